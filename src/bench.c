@@ -0,0 +1,488 @@
+#include "raylib.h"
+#include "raymath.h"
+
+// Physac is only used as the reference layout of the body benchmark
+#define PHYSAC_IMPLEMENTATION
+#define PHYSAC_AVOID_TIMMING_SYSTEM
+#include "extras/physac.h"
+
+#define CUTE_TILED_IMPLEMENTATION
+#include "cute_tiled.h"
+
+#include "binary_io.h"
+#include "body_store.h"
+#include "physics_stats.h"
+#include "wall_polygon.h"
+#include "stage_collision.h"
+#include "wall_merge.h"
+#include "wall_batch.h"
+#include "distance_field.h"
+#include "timer.h"
+#include "physics_world.h"
+#include "cache_directory.h"
+#include "stage_loader.h"
+#include "simulation.h"
+#include "event_simulation.h"
+#include "trajectory_preview.h"
+#include "worker_pool.h"
+#include "parallel_bodies.h"
+
+#define BENCH_LEVELS 3
+#define BENCH_QUERIES 1000000
+#define BENCH_BODIES 300
+#define BENCH_BODY_PASSES 2000
+#define BENCH_LARGE_SHOTS 32
+#define BENCH_LARGE_WALL_SPACING 96.0f // Side of the square each generated wall gets on average (px)
+#define BENCH_LARGE_CLEARING 64.0f     // Radius kept free of walls around the spawn (px)
+#define BENCH_MANY_BALLS 4096
+#define BENCH_MANY_TICKS 600
+#define BENCH_MANY_CHECKED 64 // Balls compared against a world of their own
+#define BENCH_PREVIEW_FRAMES 600
+#define BENCH_PREVIEW_TURN 1.5f // Degrees the drag turns every frame
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void BenchNarrowphase(int level);
+void BenchBodyLayout(int level);
+void BenchLargeStage(int wallCount);
+void BenchManyBalls(int level);
+void BenchTrajectoryPreview(int level);
+
+//----------------------------------------------------------------------------------
+// Main Enry Point
+//----------------------------------------------------------------------------------
+int main()
+{
+    printf("Narrowphase: one circle against every wall, %d queries per level, %d-wide batches\n", BENCH_QUERIES,
+           WALL_BATCH_WIDTH);
+    for (int level = 1; level <= BENCH_LEVELS; level++)
+    {
+        BenchNarrowphase(level);
+    }
+
+    printf("Bodies: %d balls, %d step and draw passes, pointers to separate allocations vs body store\n", BENCH_BODIES,
+           BENCH_BODY_PASSES);
+    for (int level = 1; level <= BENCH_LEVELS; level++)
+    {
+        BenchBodyLayout(level);
+    }
+
+    printf("Large stages: generated walls, %d shots from the center\n", BENCH_LARGE_SHOTS);
+    BenchLargeStage(1000);
+    BenchLargeStage(10000);
+
+    printf("Many balls: %d balls launched from the spawn, %d ticks, stepped in groups of %d on 1 to %d threads\n",
+           BENCH_MANY_BALLS, BENCH_MANY_TICKS, BODY_GROUP_SIZE, GetWorkerCount());
+    for (int level = 1; level <= BENCH_LEVELS; level++)
+    {
+        BenchManyBalls(level);
+    }
+
+    printf("Trajectory preview: cost of the frame update over %d frames, drag held still vs turning %.1f degrees and changing "
+           "power every frame\n",
+           BENCH_PREVIEW_FRAMES, BENCH_PREVIEW_TURN);
+    for (int level = 1; level <= BENCH_LEVELS; level++)
+    {
+        BenchTrajectoryPreview(level);
+    }
+
+    UnloadStages();
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static unsigned int benchSeed = 12345;
+
+// Deterministic pseudo random value in [0, 1)
+float BenchRandom(void)
+{
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+    return (float)(benchSeed >> 8) / 16777216.0f;
+}
+
+Vector2 *GenerateBallPositions(const WallGrid *grid, int count)
+{
+    Vector2 *positions = (Vector2 *)malloc(count * sizeof(Vector2));
+    for (int i = 0; i < count; i++)
+    {
+        positions[i].x = grid->origin.x + BenchRandom() * grid->columns * grid->cellSize;
+        positions[i].y = grid->origin.y + BenchRandom() * grid->rows * grid->cellSize;
+    }
+    return positions;
+}
+
+void BenchNarrowphase(int level)
+{
+    StageData stage = LoadStage(level);
+    WallBatch batch = BuildWallBatch(stage.world.walls, NULL, stage.world.wallCount);
+    Vector2 *positions = GenerateBallPositions(&stage.world.wallGrid, BENCH_QUERIES);
+    int overlaps[2] = {0};
+    double elapsed[2];
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+        double start = GetMonotonicTime();
+        for (int i = 0; i < BENCH_QUERIES; i++)
+        {
+            for (int first = 0; first < batch.count; first += WALL_BATCH_WIDTH)
+            {
+                int count = (batch.count - first < WALL_BATCH_WIDTH) ? batch.count - first : WALL_BATCH_WIDTH;
+                int mask = simd ? OverlapWallBatchSimd(&batch, first, count, positions[i], PLAYER_RADIUS)
+                                : OverlapWallBatchScalar(&batch, first, count, positions[i], PLAYER_RADIUS);
+                overlaps[simd] += (mask != 0);
+            }
+        }
+        elapsed[simd] = GetMonotonicTime() - start;
+    }
+
+    double start = GetMonotonicTime();
+    int contactCount = 0;
+    for (int i = 0; i < BENCH_QUERIES; i++)
+    {
+        contactCount += FindWallContacts(&stage.world.wallGrid, &stage.world.wallBatch, stage.world.walls, positions[i],
+                                         PLAYER_RADIUS, &stage.world.contacts, NULL);
+    }
+    double gridElapsed = GetMonotonicTime() - start;
+
+    // Field lookups, and how many of them rule out a contact the exact search would find
+    start = GetMonotonicTime();
+    int clear = 0;
+    for (int i = 0; i < BENCH_QUERIES; i++)
+    {
+        clear += (GetWallClearance(&stage.world.wallField, positions[i], PLAYER_RADIUS) > 0);
+    }
+    double fieldElapsed = GetMonotonicTime() - start;
+
+    int missed = 0;
+    for (int i = 0; i < BENCH_QUERIES; i++)
+    {
+        missed += (GetWallClearance(&stage.world.wallField, positions[i], PLAYER_RADIUS) > 0 &&
+                   FindWallContacts(&stage.world.wallGrid, &stage.world.wallBatch, stage.world.walls, positions[i],
+                                    PLAYER_RADIUS, &stage.world.contacts, NULL) > 0);
+    }
+
+    printf("level %d (%d walls): scalar %.1f ns, simd %.1f ns (%.2fx), grid + simd contacts %.1f ns%s\n", level,
+           stage.world.wallCount, elapsed[0] * 1e9 / BENCH_QUERIES, elapsed[1] * 1e9 / BENCH_QUERIES, elapsed[0] / elapsed[1],
+           gridElapsed * 1e9 / BENCH_QUERIES, (overlaps[0] == overlaps[1]) ? "" : " (MISMATCH)");
+    printf("  distance field %.1f ns, %.0f%% of positions clear of the walls%s\n", fieldElapsed * 1e9 / BENCH_QUERIES,
+           clear * 100.0 / BENCH_QUERIES, (missed == 0) ? "" : " (MISSED CONTACTS)");
+
+    (void)contactCount;
+    free(positions);
+    FreeWallBatch(&batch);
+    FreeStage(&stage);
+}
+
+// Reflect a velocity off the walls a circle touches
+static Vector2 BounceOffWalls(StageData *stage, Vector2 position, float radius, Vector2 velocity)
+{
+    int contactCount = FindWallContacts(&stage->world.wallGrid, &stage->world.wallBatch, stage->world.walls, position, radius,
+                                        &stage->world.contacts, NULL);
+    const WallContact *contacts = stage->world.contacts.contacts;
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        float contactVelocity = Vector2DotProduct(velocity, contacts[i].normal);
+        if (contactVelocity < 0)
+        {
+            velocity = Vector2Subtract(velocity, Vector2Scale(contacts[i].normal, 2.0f * contactVelocity));
+        }
+    }
+
+    return velocity;
+}
+
+// Same step (wall contacts, integration) and draw pass (outline vertices) over the same
+// balls, once reached through one pointer per separately allocated body the way physac
+// keeps them, once streamed from the body store arrays
+void BenchBodyLayout(int level)
+{
+    StageData stage = LoadStage(level);
+    Vector2 *positions = GenerateBallPositions(&stage.world.wallGrid, BENCH_BODIES);
+    float deltaTime = 1000.0f / 60.0f;
+
+    // Allocated one by one like CreatePhysicsBodyCircle() does, past PHYSAC_MAX_BODIES
+    PhysicsBody *pointers = (PhysicsBody *)malloc(BENCH_BODIES * sizeof(PhysicsBody));
+    ClearBodyStore(&stage.world.bodies);
+    for (int i = 0; i < BENCH_BODIES; i++)
+    {
+        pointers[i] = (PhysicsBody)calloc(1, sizeof(PhysicsBodyData));
+        pointers[i]->enabled = true;
+        pointers[i]->position = positions[i];
+        pointers[i]->velocity = (Vector2){BenchRandom() * 0.1f - 0.05f, BenchRandom() * 0.1f - 0.05f};
+        pointers[i]->shape.type = PHYSICS_CIRCLE;
+        pointers[i]->shape.radius = PLAYER_RADIUS;
+
+        BodyHandle body = CreateBody(&stage.world.bodies, positions[i], PLAYER_RADIUS);
+        stage.world.bodies.velocity[body] = pointers[i]->velocity;
+    }
+
+    Vector2 checksum[2] = {0};
+    double stepElapsed[2];
+    double drawElapsed[2];
+
+    double start = GetMonotonicTime();
+    for (int pass = 0; pass < BENCH_BODY_PASSES; pass++)
+    {
+        for (int i = 0; i < BENCH_BODIES; i++)
+        {
+            PhysicsBody body = pointers[i];
+            body->velocity = BounceOffWalls(&stage, body->position, body->shape.radius, body->velocity);
+            body->position = Vector2Add(body->position, Vector2Scale(body->velocity, deltaTime));
+        }
+    }
+    stepElapsed[0] = GetMonotonicTime() - start;
+
+    start = GetMonotonicTime();
+    for (int pass = 0; pass < BENCH_BODY_PASSES; pass++)
+    {
+        for (int i = 0; i < BENCH_BODIES; i++)
+        {
+            for (int j = 0; j < BODY_OUTLINE_SIDES; j++)
+            {
+                checksum[0] = Vector2Add(checksum[0], GetPhysicsShapeVertex(pointers[i], j));
+            }
+        }
+    }
+    drawElapsed[0] = GetMonotonicTime() - start;
+
+    BodyStore *bodies = &stage.world.bodies;
+    start = GetMonotonicTime();
+    for (int pass = 0; pass < BENCH_BODY_PASSES; pass++)
+    {
+        for (BodyHandle body = 0; body < bodies->count; body++)
+        {
+            bodies->velocity[body] = BounceOffWalls(&stage, bodies->position[body], bodies->radius[body], bodies->velocity[body]);
+            bodies->position[body] = Vector2Add(bodies->position[body], Vector2Scale(bodies->velocity[body], deltaTime));
+        }
+    }
+    stepElapsed[1] = GetMonotonicTime() - start;
+
+    start = GetMonotonicTime();
+    for (int pass = 0; pass < BENCH_BODY_PASSES; pass++)
+    {
+        for (BodyHandle body = 0; body < bodies->count; body++)
+        {
+            for (int j = 0; j < BODY_OUTLINE_SIDES; j++)
+            {
+                float angle = (360.0f / BODY_OUTLINE_SIDES * j) * DEG2RAD + bodies->orient[body];
+                checksum[1].x += bodies->position[body].x + cosf(angle) * bodies->radius[body];
+                checksum[1].y += bodies->position[body].y + sinf(angle) * bodies->radius[body];
+            }
+        }
+    }
+    drawElapsed[1] = GetMonotonicTime() - start;
+
+    // Draw passes only agree up to rounding, the physac vertex angle is computed differently
+    bool match = fabsf(checksum[0].x - checksum[1].x) <= fabsf(checksum[0].x) * 1e-3f &&
+                 fabsf(checksum[0].y - checksum[1].y) <= fabsf(checksum[0].y) * 1e-3f;
+    for (int i = 0; i < BENCH_BODIES; i++)
+    {
+        match = match && pointers[i]->position.x == bodies->position[i].x && pointers[i]->position.y == bodies->position[i].y;
+    }
+
+    float steps = (float)BENCH_BODY_PASSES * BENCH_BODIES;
+    printf("level %d: step pointers %.1f ns, store %.1f ns (%.2fx), draw pointers %.1f ns, store %.1f ns (%.2fx)%s\n", level,
+           stepElapsed[0] * 1e9 / steps, stepElapsed[1] * 1e9 / steps, stepElapsed[0] / stepElapsed[1],
+           drawElapsed[0] * 1e9 / steps, drawElapsed[1] * 1e9 / steps, drawElapsed[0] / drawElapsed[1],
+           match ? "" : " (MISMATCH)");
+
+    for (int i = 0; i < BENCH_BODIES; i++)
+    {
+        free(pointers[i]);
+    }
+    free(pointers);
+    free(positions);
+    FreeStage(&stage);
+}
+
+// Tiled map of a square stage: a border, wallCount small walls scattered inside (one in
+// four rotated), the spawn in the center and the goal in a corner
+static char *GenerateStageJson(int wallCount, int *size)
+{
+    float side = sqrtf((float)wallCount) * BENCH_LARGE_WALL_SPACING;
+    Vector2 center = {side / 2.0f, side / 2.0f};
+    char *json = (char *)malloc((wallCount + 8) * 160 + 512);
+    int length = 0;
+
+    length += sprintf(json + length, "{\"height\":1,\"width\":1,\"tilewidth\":56,\"tileheight\":56,"
+                                     "\"orientation\":\"orthogonal\",\"renderorder\":\"right-down\",\"infinite\":false,"
+                                     "\"type\":\"map\",\"version\":\"1.6\",\"tilesets\":[],\"layers\":[{\"id\":1,"
+                                     "\"name\":\"entities\",\"type\":\"objectgroup\",\"draworder\":\"topdown\","
+                                     "\"opacity\":1,\"visible\":true,\"x\":0,\"y\":0,\"objects\":[");
+    length += sprintf(json + length, "{\"id\":1,\"point\":true,\"x\":%.0f,\"y\":%.0f,\"width\":0,\"height\":0,"
+                                     "\"properties\":[{\"name\":\"start\",\"type\":\"string\",\"value\":\"\"}]},",
+                      center.x, center.y);
+    length += sprintf(json + length, "{\"id\":2,\"ellipse\":true,\"x\":56,\"y\":56,\"width\":56,\"height\":56}");
+
+    Rectangle border[4] = {{-56, -56, side + 112, 56}, {-56, side, side + 112, 56}, {-56, 0, 56, side}, {side, 0, 56, side}};
+    for (int i = 0; i < 4; i++)
+    {
+        length += sprintf(json + length, ",{\"id\":%d,\"x\":%.0f,\"y\":%.0f,\"width\":%.0f,\"height\":%.0f,\"rotation\":0}",
+                          3 + i, border[i].x, border[i].y, border[i].width, border[i].height);
+    }
+
+    for (int i = 0; i < wallCount; i++)
+    {
+        Rectangle wall;
+        do
+        {
+            wall = (Rectangle){BenchRandom() * side, BenchRandom() * side, 8 + BenchRandom() * 24, 8 + BenchRandom() * 24};
+        } while (Vector2Distance((Vector2){wall.x, wall.y}, center) < BENCH_LARGE_CLEARING);
+        float rotation = (i % 4 == 0) ? BenchRandom() * 90.0f : 0.0f;
+
+        length += sprintf(json + length, ",{\"id\":%d,\"x\":%.1f,\"y\":%.1f,\"width\":%.1f,\"height\":%.1f,\"rotation\":%.1f}",
+                          7 + i, wall.x, wall.y, wall.width, wall.height, rotation);
+    }
+
+    length += sprintf(json + length, "]}]}");
+    *size = length;
+
+    return json;
+}
+
+// Load and play a generated stage far past the size of the shipped levels: parsing and
+// building its colliders, then shots in every direction with the real simulation
+void BenchLargeStage(int wallCount)
+{
+    int size;
+    char *json = GenerateStageJson(wallCount, &size);
+
+    double start = GetMonotonicTime();
+    StageAssets assets = BuildStageAssets(0, cute_tiled_load_map_from_memory(json, size, NULL), NULL);
+    double loadElapsed = GetMonotonicTime() - start;
+
+    StageData stage = {0};
+    PhysicsStats stats = {0};
+    SetupStage(&stage, &assets);
+    stage.world.stats = &stats;
+
+    long ticks = 0;
+    start = GetMonotonicTime();
+    for (int shot = 0; shot < BENCH_LARGE_SHOTS; shot++)
+    {
+        float angle = 2.0f * PI * shot / BENCH_LARGE_SHOTS;
+        int shotTicks;
+        SimulateShot(&stage, (Vector2){cosf(angle) * MAX_LAUNCH_DISTANCE, sinf(angle) * MAX_LAUNCH_DISTANCE}, &shotTicks, NULL);
+        ticks += shotTicks;
+    }
+    double elapsed = GetMonotonicTime() - start;
+
+    printf("%d walls (%dx%d grid): load %.2f ms, %ld ticks at %.2f us, %d contact points, %.2f ms of sweeps dropped\n",
+           assets.wallCount, assets.wallGrid.columns, assets.wallGrid.rows, loadElapsed * 1e3, ticks,
+           elapsed * 1e6 / ticks, stats.contactPoints, stats.droppedSweepTime);
+
+    FreeStage(&stage);
+    FreeStageAssets(&assets);
+    free(json);
+}
+
+// Launch many balls at once and step them on more and more threads. Every ball has to end
+// where it would alone in the world, whatever the thread count.
+void BenchManyBalls(int level)
+{
+    StageData stage = LoadStage(level);
+    PhysicsWorld *world = &stage.world;
+    BodyStore initial = {0};
+    BodyGroups groups = {0};
+
+    ClearBodyStore(&world->bodies);
+    for (int i = 0; i < BENCH_MANY_BALLS; i++)
+    {
+        BodyHandle body = CreateBody(&world->bodies, stage.initialPlayerPosition, PLAYER_RADIUS);
+        float angle = BenchRandom() * 2.0f * PI;
+        float power = 0.2f + BenchRandom() * 0.8f;
+        world->bodies.velocity[body] = GetLaunchVelocity((Vector2){cosf(angle) * power * MAX_LAUNCH_DISTANCE,
+                                                                   sinf(angle) * power * MAX_LAUNCH_DISTANCE});
+        world->bodies.restitution[body] = 1.0f;
+        world->bodies.damping[body] = (BodyDamping){BALL_DECELERATION, BALL_REST_SPEED};
+    }
+    CopyBodyStore(&initial, &world->bodies);
+
+    // Reference: a few of the balls, each stepped alone in a copy of the world
+    Vector2 expected[BENCH_MANY_CHECKED];
+    PhysicsWorld single = {0};
+    for (int i = 0; i < BENCH_MANY_CHECKED; i++)
+    {
+        CopyPhysicsWorld(&single, world);
+        single.stats = NULL;
+        single.bodies.count = 0;
+        BodyHandle body = CreateBody(&single.bodies, initial.position[i], initial.radius[i]);
+        single.bodies.velocity[body] = initial.velocity[i];
+        single.bodies.restitution[body] = initial.restitution[i];
+        single.bodies.damping[body] = initial.damping[i];
+        for (int tick = 0; tick < BENCH_MANY_TICKS; tick++)
+        {
+            StepPhysicsWorld(&single, SIMULATION_TICK);
+        }
+        expected[i] = single.bodies.position[body];
+    }
+    FreePhysicsWorld(&single);
+
+    printf("level %d:", level);
+    double baseline = 0.0;
+    bool match = true;
+    int maxWorkers = GetWorkerCount();
+    for (int workers = 1; workers <= maxWorkers; workers = (workers * 2 > maxWorkers && workers < maxWorkers) ? maxWorkers : workers * 2)
+    {
+        CopyBodyStore(&world->bodies, &initial);
+
+        double start = GetMonotonicTime();
+        StepBodiesParallel(world, &groups, SIMULATION_TICK, BENCH_MANY_TICKS, workers);
+        double elapsed = GetMonotonicTime() - start;
+        baseline = (workers == 1) ? elapsed : baseline;
+
+        for (int i = 0; i < BENCH_MANY_CHECKED; i++)
+        {
+            match = match && world->bodies.position[i].x == expected[i].x && world->bodies.position[i].y == expected[i].y;
+        }
+        printf(" %d %s %.1f ms (%.2fx)%s", workers, (workers == 1) ? "thread" : "threads", elapsed * 1e3, baseline / elapsed,
+               (workers < maxWorkers) ? "," : "");
+    }
+    printf("%s\n", match ? "" : " (MISMATCH)");
+
+    FreeBodyGroups(&groups);
+    FreeBodyStore(&initial);
+    FreeStage(&stage);
+}
+
+void BenchTrajectoryPreview(int level)
+{
+    StageData stage = LoadStage(level);
+    TrajectoryPreview preview = {0};
+
+    printf("level %d:", level);
+    for (int moving = 0; moving <= 1; moving++)
+    {
+        double total = 0.0;
+        double slowest = 0.0;
+        int completeFrames = 0;
+        int points = 0;
+        for (int frame = 0; frame < BENCH_PREVIEW_FRAMES; frame++)
+        {
+            float angle = moving ? frame * BENCH_PREVIEW_TURN * DEG2RAD : 0.3f;
+            float power = moving ? 0.6f + 0.4f * sinf(frame * 0.05f) : 1.0f;
+            Vector2 directionVector = {cosf(angle) * power * MAX_LAUNCH_DISTANCE, sinf(angle) * power * MAX_LAUNCH_DISTANCE};
+
+            double start = GetMonotonicTime();
+            UpdateTrajectoryPreview(&preview, &stage, directionVector);
+            double elapsed = GetMonotonicTime() - start;
+
+            total += elapsed;
+            slowest = fmax(slowest, elapsed);
+            completeFrames += preview.complete ? 1 : 0;
+            points += preview.pointCount;
+        }
+        printf(" %s %.2f us/frame (max %.2f us), %d%% of frames with the whole path, %.1f points%s", moving ? "turning" : "still",
+               total / BENCH_PREVIEW_FRAMES * 1e6, slowest * 1e6, completeFrames * 100 / BENCH_PREVIEW_FRAMES,
+               (float)points / BENCH_PREVIEW_FRAMES, moving ? "" : ",");
+        FreeTrajectoryPreview(&preview);
+    }
+    printf("\n");
+
+    FreeStage(&stage);
+}
@@ -0,0 +1,52 @@
+// Hashing and portable binary files shared by the caches and replays. Files store values
+// as little endian 32 bit words, so they read back the same on any machine.
+#include <stdio.h>
+#include <string.h>
+
+#define HASH_BASIS 2166136261u
+
+// Fold bytes into a hash, start from HASH_BASIS (FNV-1a)
+unsigned int HashBytes(unsigned int hash, const void *data, int size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (int i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool WriteFileWord(FILE *file, unsigned int value)
+{
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF};
+    return fwrite(bytes, 1, 4, file) == 4;
+}
+
+bool WriteFileFloat(FILE *file, float value)
+{
+    unsigned int word;
+    memcpy(&word, &value, sizeof(word));
+    return WriteFileWord(file, word);
+}
+
+bool ReadFileWord(FILE *file, unsigned int *value)
+{
+    unsigned char bytes[4];
+    if (fread(bytes, 1, 4, file) != 4)
+    {
+        return false;
+    }
+    *value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+    return true;
+}
+
+bool ReadFileFloat(FILE *file, float *value)
+{
+    unsigned int word;
+    if (!ReadFileWord(file, &word))
+    {
+        return false;
+    }
+    memcpy(value, &word, sizeof(word));
+    return true;
+}
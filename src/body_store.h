@@ -0,0 +1,140 @@
+// Dynamic bodies in struct-of-arrays form. Each property of every body sits in its own
+// contiguous array, so the physics step and the render loop stream through exactly the
+// data they read. Bodies are referred to by integer handles (their index in the arrays);
+// bodies are only ever created, or all cleared at once, so a handle stays valid until
+// the store is cleared. Every body is a circle.
+// The arrays grow with the number of bodies, a store owns them until FreeBodyStore().
+#include <stdlib.h>
+#include <string.h>
+
+#define BODY_STORE_MIN_CAPACITY 8
+#define BODY_OUTLINE_SIDES 24 // Segments of a drawn body outline
+
+typedef int BodyHandle;
+
+// Velocity loss of a body, applied by every physics substep
+typedef struct BodyDamping
+{
+    float deceleration; // Constant deceleration against the motion (px/ms per ms)
+    float restSpeed;    // Below this speed (px/ms) the body stops
+} BodyDamping;
+
+typedef struct BodyStore
+{
+    int count;
+    int capacity;
+    Vector2 *position;
+    Vector2 *velocity; // px/ms
+    float *orient;     // Radians
+    Vector2 *previousPosition; // State at the start of the current tick, for render interpolation
+    float *previousOrient;
+    float *radius;
+    float *restitution;
+    BodyDamping *damping;
+    bool *enabled;
+} BodyStore;
+
+// Make room for at least capacity bodies without moving again, bodies and handles are kept
+void ReserveBodies(BodyStore *store, int capacity)
+{
+    if (capacity <= store->capacity)
+    {
+        return;
+    }
+
+    store->position = (Vector2 *)realloc(store->position, capacity * sizeof(Vector2));
+    store->velocity = (Vector2 *)realloc(store->velocity, capacity * sizeof(Vector2));
+    store->orient = (float *)realloc(store->orient, capacity * sizeof(float));
+    store->previousPosition = (Vector2 *)realloc(store->previousPosition, capacity * sizeof(Vector2));
+    store->previousOrient = (float *)realloc(store->previousOrient, capacity * sizeof(float));
+    store->radius = (float *)realloc(store->radius, capacity * sizeof(float));
+    store->restitution = (float *)realloc(store->restitution, capacity * sizeof(float));
+    store->damping = (BodyDamping *)realloc(store->damping, capacity * sizeof(BodyDamping));
+    store->enabled = (bool *)realloc(store->enabled, capacity * sizeof(bool));
+    store->capacity = capacity;
+}
+
+// Add a circle body at rest, the store grows when it is full
+BodyHandle CreateBody(BodyStore *store, Vector2 position, float radius)
+{
+    if (store->count == store->capacity)
+    {
+        ReserveBodies(store, (store->capacity > 0) ? store->capacity * 2 : BODY_STORE_MIN_CAPACITY);
+    }
+
+    BodyHandle body = store->count++;
+    store->position[body] = position;
+    store->velocity[body] = (Vector2){0, 0};
+    store->orient[body] = 0.0f;
+    store->previousPosition[body] = position;
+    store->previousOrient[body] = 0.0f;
+    store->radius[body] = radius;
+    store->restitution[body] = 1.0f;
+    store->damping[body] = (BodyDamping){0};
+    store->enabled[body] = true;
+
+    return body;
+}
+
+// Move a body without the renderer interpolating across the jump
+void TeleportBody(BodyStore *store, BodyHandle body, Vector2 position)
+{
+    store->position[body] = position;
+    store->previousPosition[body] = position;
+}
+
+// Remember the current state of every body as the start of a new tick
+void SaveBodyStates(BodyStore *store)
+{
+    memcpy(store->previousPosition, store->position, store->count * sizeof(Vector2));
+    memcpy(store->previousOrient, store->orient, store->count * sizeof(float));
+}
+
+// Body transform between the previous and the current tick, alpha in [0, 1]
+Vector2 GetInterpolatedBodyPosition(const BodyStore *store, BodyHandle body, float alpha)
+{
+    return Vector2Lerp(store->previousPosition[body], store->position[body], alpha);
+}
+
+float GetInterpolatedBodyOrient(const BodyStore *store, BodyHandle body, float alpha)
+{
+    return Lerp(store->previousOrient[body], store->orient[body], alpha);
+}
+
+// Remove every body, all handles become invalid. The arrays are kept for new bodies.
+void ClearBodyStore(BodyStore *store)
+{
+    store->count = 0;
+}
+
+// Make destination hold the same bodies as source, reusing the destination arrays
+void CopyBodyStore(BodyStore *destination, const BodyStore *source)
+{
+    ReserveBodies(destination, source->count);
+
+    int count = source->count;
+    destination->count = count;
+    memcpy(destination->position, source->position, count * sizeof(Vector2));
+    memcpy(destination->velocity, source->velocity, count * sizeof(Vector2));
+    memcpy(destination->orient, source->orient, count * sizeof(float));
+    memcpy(destination->previousPosition, source->previousPosition, count * sizeof(Vector2));
+    memcpy(destination->previousOrient, source->previousOrient, count * sizeof(float));
+    memcpy(destination->radius, source->radius, count * sizeof(float));
+    memcpy(destination->restitution, source->restitution, count * sizeof(float));
+    memcpy(destination->damping, source->damping, count * sizeof(BodyDamping));
+    memcpy(destination->enabled, source->enabled, count * sizeof(bool));
+}
+
+void FreeBodyStore(BodyStore *store)
+{
+    free(store->position);
+    free(store->velocity);
+    free(store->orient);
+    free(store->previousPosition);
+    free(store->previousOrient);
+    free(store->radius);
+    free(store->restitution);
+    free(store->damping);
+    free(store->enabled);
+    *store = (BodyStore){0};
+}
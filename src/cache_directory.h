@@ -0,0 +1,69 @@
+// Per-user directory for files the game derives from its assets (distance fields), so
+// they are never written next to the shipped resources, which may be read-only. The
+// MOMENTUM_PRIMAL_CACHE_DIR environment variable picks another directory (the build
+// uses one in the build tree). There is no cache on the web, derived data is rebuilt.
+#if defined(_WIN32)
+#include <direct.h>
+#elif !defined(PLATFORM_WEB)
+#include <sys/stat.h>
+#endif
+
+#define CACHE_DIRECTORY_NAME "momentum-primal"
+
+static bool MakeCacheDirectory(const char *path)
+{
+#if defined(_WIN32)
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+    return DirectoryExists(path);
+}
+
+// Write the path of a cache file to path (size bytes), creating the cache directory when
+// needed. Returns false when there is no usable cache directory, callers then rebuild
+// the data instead of caching it.
+bool GetCacheFilePath(const char *fileName, char *path, int size)
+{
+#if defined(PLATFORM_WEB)
+    return false;
+#else
+    char directory[512];
+    const char *override = getenv("MOMENTUM_PRIMAL_CACHE_DIR");
+    const char *base;
+
+    if (override != NULL && override[0] != '\0')
+    {
+        snprintf(directory, sizeof(directory), "%s", override);
+    }
+#if defined(_WIN32)
+    else if ((base = getenv("LOCALAPPDATA")) != NULL)
+    {
+        snprintf(directory, sizeof(directory), "%s\\" CACHE_DIRECTORY_NAME, base);
+    }
+#else
+    else if ((base = getenv("XDG_CACHE_HOME")) != NULL && base[0] == '/')
+    {
+        snprintf(directory, sizeof(directory), "%s/" CACHE_DIRECTORY_NAME, base);
+    }
+    else if ((base = getenv("HOME")) != NULL && base[0] != '\0')
+    {
+        snprintf(directory, sizeof(directory), "%s/.cache", base);
+        MakeCacheDirectory(directory);
+        snprintf(directory, sizeof(directory), "%s/.cache/" CACHE_DIRECTORY_NAME, base);
+    }
+#endif
+    else
+    {
+        return false;
+    }
+
+    if (!MakeCacheDirectory(directory))
+    {
+        TraceLog(LOG_INFO, "CACHE: No cache directory at %s, derived data is rebuilt", directory);
+        return false;
+    }
+
+    return snprintf(path, size, "%s/%s", directory, fileName) < size;
+#endif
+}
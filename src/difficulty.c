@@ -0,0 +1,353 @@
+#include "raylib.h"
+#include "raymath.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+#define CUTE_TILED_IMPLEMENTATION
+#include "cute_tiled.h"
+
+#include "binary_io.h"
+#include "body_store.h"
+#include "physics_stats.h"
+#include "wall_polygon.h"
+#include "stage_collision.h"
+#include "wall_merge.h"
+#include "wall_batch.h"
+#include "distance_field.h"
+#include "timer.h"
+#include "physics_world.h"
+#include "cache_directory.h"
+#include "stage_loader.h"
+#include "simulation.h"
+#include "event_simulation.h"
+#include "worker_pool.h"
+
+#define DIFFICULTY_SAMPLES 4096
+#define DIFFICULTY_BATCH 64        // Launches per task, each task simulates on its own copy of the stage
+#define HEATMAP_DIRECTIONS 72      // Columns of the heatmap, 5 degrees each
+#define HEATMAP_POWERS 20          // Rows of the heatmap, weakest launch at the bottom
+#define HEATMAP_CELL_SIZE 8        // px per heatmap cell
+#define DIFFICULTY_USAGE "[-n samples] [-r seed] [-o directory] [-e] [level ...]"
+
+typedef struct LevelDifficulty
+{
+    int level;
+    int samples;
+    int wins;
+    int *cellSamples; // Launches per heatmap cell, direction major
+    int *cellWins;
+} LevelDifficulty;
+
+typedef struct DifficultyJob
+{
+    const StageData *stage;
+    unsigned int seed;
+    bool events;     // Simulate with SimulateShotEvents() instead of stepping
+    int samples;
+    Vector2 *launches;
+    bool *wins;
+} DifficultyJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LevelDifficulty EstimateLevelDifficulty(int level, int samples, unsigned int seed, bool events);
+bool ExportDifficultyHeatmap(const LevelDifficulty *difficulty, const char *path);
+bool ParseInteger(const char *text, int *value);
+bool ParseSeed(const char *text, unsigned int *seed);
+
+//----------------------------------------------------------------------------------
+// Main Enry Point
+//----------------------------------------------------------------------------------
+// Usage: momentum-primal-difficulty [-n samples] [-r seed] [-o directory] [-e] [level ...]
+// Simulates random launches (uniform direction and drag distance, as the player drags
+// them) from the spawn of each level, reports the fraction that end in the goal, and
+// writes a heatmap of winning directions and powers to difficulty_level%d.png. Levels
+// are listed from the easiest to the hardest at the end. Without levels, every
+// resources/level%d.json file is estimated.
+// Launches only depend on the seed, so a run is reproducible on any number of threads.
+// -e simulates with the event driven engine, several times faster and within a fraction
+// of a percent of the stepped one.
+// Exits with 1 on unknown arguments, or when a level does not exist or has no winning
+// launch among the samples.
+int main(int argc, char **argv)
+{
+    int samples = DIFFICULTY_SAMPLES;
+    unsigned int seed = 1;
+    const char *directory = ".";
+    bool events = false;
+    int *levels = (int *)malloc(argc * sizeof(int));
+    int levelCount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool valid = true;
+        if (strcmp(argv[i], "-n") == 0)
+        {
+            valid = i + 1 < argc && ParseInteger(argv[++i], &samples) && samples > 0;
+        }
+        else if (strcmp(argv[i], "-r") == 0)
+        {
+            valid = i + 1 < argc && ParseSeed(argv[++i], &seed);
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            valid = i + 1 < argc;
+            directory = valid ? argv[++i] : directory;
+        }
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            events = true;
+        }
+        else
+        {
+            valid = ParseInteger(argv[i], &levels[levelCount]);
+            levelCount += valid ? 1 : 0;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Usage: %s " DIFFICULTY_USAGE "\n", argv[0]);
+            free(levels);
+            return 1;
+        }
+    }
+
+    if (levelCount == 0)
+    {
+        while (FileExists(TextFormat("resources/level%d.json", levelCount + 1)))
+        {
+            levelCount++;
+        }
+        levels = (int *)realloc(levels, (levelCount + 1) * sizeof(int));
+        for (int i = 0; i < levelCount; i++)
+        {
+            levels[i] = i + 1;
+        }
+    }
+
+    if (levelCount == 0)
+    {
+        fprintf(stderr, "No levels to estimate\n");
+        free(levels);
+        return 1;
+    }
+
+    LevelDifficulty *difficulties = (LevelDifficulty *)malloc(levelCount * sizeof(LevelDifficulty));
+    int estimated = 0;
+    int missing = 0;
+    int unsolved = 0;
+    for (int i = 0; i < levelCount; i++)
+    {
+        // Levels without a file are errors, the game would play level 1 in their place
+        if (GetStageAssets(levels[i]) == NULL)
+        {
+            fprintf(stderr, "level %d: no resources/level%d.json\n", levels[i], levels[i]);
+            missing++;
+            continue;
+        }
+
+        double start = GetMonotonicTime();
+        LevelDifficulty *difficulty = &difficulties[estimated++];
+        *difficulty = EstimateLevelDifficulty(levels[i], samples, seed, events);
+        double elapsed = GetMonotonicTime() - start;
+
+        // Binomial standard error of the win fraction
+        float winRate = (float)difficulty->wins / difficulty->samples;
+        float error = sqrtf(winRate * (1.0f - winRate) / difficulty->samples);
+        const char *path = TextFormat("%s/difficulty_level%d.png", directory, levels[i]);
+        bool exported = ExportDifficultyHeatmap(difficulty, path);
+
+        printf("level %d: %d/%d random launches win (%.2f%% +- %.2f%%) in %.2f s on %d threads%s, heatmap %s\n",
+               levels[i], difficulty->wins, difficulty->samples, 100.0f * winRate, 100.0f * error, elapsed,
+               GetWorkerCount(), events ? " (events)" : "", exported ? path : "not written");
+
+        if (difficulty->wins == 0)
+        {
+            unsolved++;
+        }
+    }
+    UnloadStages();
+
+    // Easiest first (every level has as many samples), ties keep the level order
+    int *order = (int *)malloc((estimated + 1) * sizeof(int));
+    for (int i = 0; i < estimated; i++)
+    {
+        int position = i;
+        while (position > 0 && difficulties[order[position - 1]].wins < difficulties[i].wins)
+        {
+            order[position] = order[position - 1];
+            position--;
+        }
+        order[position] = i;
+    }
+
+    printf("levels from the easiest to the hardest:");
+    for (int i = 0; i < estimated; i++)
+    {
+        const LevelDifficulty *difficulty = &difficulties[order[i]];
+        printf(" %d (%.2f%%)", difficulty->level, 100.0f * difficulty->wins / difficulty->samples);
+        free(difficulty->cellSamples);
+        free(difficulty->cellWins);
+    }
+    printf("\n");
+    free(order);
+    free(difficulties);
+    free(levels);
+
+    if (missing > 0)
+    {
+        fprintf(stderr, "%d of %d levels do not exist\n", missing, levelCount);
+    }
+    if (unsolved > 0)
+    {
+        fprintf(stderr, "%d of %d levels have no winning launch among %d samples\n", unsolved, levelCount, samples);
+    }
+
+    return (missing > 0 || unsolved > 0) ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Whole argument as a decimal int, false on anything else
+bool ParseInteger(const char *text, int *value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || parsed < INT_MIN || parsed > INT_MAX)
+    {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+// Whole argument as a 32 bit unsigned seed, false on anything else
+bool ParseSeed(const char *text, unsigned int *seed)
+{
+    char *end;
+    errno = 0;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || text[0] == '-' || parsed > UINT_MAX)
+    {
+        return false;
+    }
+    *seed = (unsigned int)parsed;
+    return true;
+}
+
+// Uniform random value in [0, 1) for a sample, from a hash of the seed and the sample
+// index (a 32 bit integer mix), so samples never depend on which thread draws them
+static float GetSampleRandom(unsigned int seed, int sample, int dimension)
+{
+    unsigned int x = seed * 0x9E3779B9u + (unsigned int)sample * 2u + (unsigned int)dimension;
+    x = (x ^ (x >> 16)) * 0x21F0AAADu;
+    x = (x ^ (x >> 15)) * 0x735A2D97u;
+    x ^= x >> 15;
+
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Drag vector (ball - cursor) of a random launch. The player drags anywhere up to the
+// maximum distance, so direction and distance are both uniform.
+Vector2 GetRandomLaunch(unsigned int seed, int sample)
+{
+    float angle = 2.0f * PI * GetSampleRandom(seed, sample, 0);
+    float distance = MAX_LAUNCH_DISTANCE * (1.0f - GetSampleRandom(seed, sample, 1));
+
+    return (Vector2){cosf(angle) * distance, sinf(angle) * distance};
+}
+
+// Each task simulates a batch of launches on its own copy of the stage; events only read
+// the stage
+static void EstimateBatch(int index, void *userData)
+{
+    DifficultyJob *job = (DifficultyJob *)userData;
+    int first = index * DIFFICULTY_BATCH;
+    int last = (first + DIFFICULTY_BATCH < job->samples) ? first + DIFFICULTY_BATCH : job->samples;
+
+    StageData stage = {0};
+    if (!job->events)
+    {
+        CopyStage(&stage, job->stage);
+    }
+
+    for (int sample = first; sample < last; sample++)
+    {
+        Vector2 launch = GetRandomLaunch(job->seed, sample);
+        ShotResult result = job->events ? SimulateShotEvents(job->stage, launch, NULL, NULL) : SimulateShot(&stage, launch, NULL, NULL);
+        job->launches[sample] = launch;
+        job->wins[sample] = (result == SHOT_GOAL);
+    }
+
+    if (!job->events)
+    {
+        FreeStage(&stage);
+    }
+}
+
+// Simulate random launches from the spawn of a level and bin them by direction and power.
+// The seed is mixed with the level, so levels do not share their launches.
+LevelDifficulty EstimateLevelDifficulty(int level, int samples, unsigned int seed, bool events)
+{
+    StageData stage = LoadStage(level);
+    DifficultyJob job = {&stage, seed ^ ((unsigned int)level * 0x85EBCA6Bu), events, samples,
+                         (Vector2 *)malloc(samples * sizeof(Vector2)), (bool *)malloc(samples * sizeof(bool))};
+
+    RunParallel((samples + DIFFICULTY_BATCH - 1) / DIFFICULTY_BATCH, EstimateBatch, &job);
+
+    LevelDifficulty difficulty = {level, samples, 0, (int *)calloc(HEATMAP_DIRECTIONS * HEATMAP_POWERS, sizeof(int)),
+                                  (int *)calloc(HEATMAP_DIRECTIONS * HEATMAP_POWERS, sizeof(int))};
+    for (int i = 0; i < samples; i++)
+    {
+        Vector2 launch = job.launches[i];
+        float angle = atan2f(launch.y, launch.x);
+        int direction = (int)((angle < 0 ? angle + 2.0f * PI : angle) / (2.0f * PI) * HEATMAP_DIRECTIONS);
+        int power = (int)(Vector2Length(launch) / MAX_LAUNCH_DISTANCE * HEATMAP_POWERS);
+        int cell = Clamp(direction, 0, HEATMAP_DIRECTIONS - 1) * HEATMAP_POWERS + Clamp(power, 0, HEATMAP_POWERS - 1);
+
+        difficulty.cellSamples[cell]++;
+        difficulty.cellWins[cell] += job.wins[i];
+        difficulty.wins += job.wins[i];
+    }
+
+    free(job.launches);
+    free(job.wins);
+    FreeStage(&stage);
+
+    return difficulty;
+}
+
+// Write the win fraction of every direction (left to right, from +x towards +y) and
+// power (bottom to top) cell as a PNG: black never wins, green always does, and cells
+// no sample fell in stay gray
+bool ExportDifficultyHeatmap(const LevelDifficulty *difficulty, const char *path)
+{
+    Image heatmap = GenImageColor(HEATMAP_DIRECTIONS * HEATMAP_CELL_SIZE, HEATMAP_POWERS * HEATMAP_CELL_SIZE, GRAY);
+
+    for (int direction = 0; direction < HEATMAP_DIRECTIONS; direction++)
+    {
+        for (int power = 0; power < HEATMAP_POWERS; power++)
+        {
+            int cell = direction * HEATMAP_POWERS + power;
+            if (difficulty->cellSamples[cell] == 0)
+            {
+                continue;
+            }
+
+            float winRate = (float)difficulty->cellWins[cell] / difficulty->cellSamples[cell];
+            Color color = {(unsigned char)(20 * (1.0f - winRate)), (unsigned char)(20 + 208 * winRate),
+                           (unsigned char)(20 + 28 * winRate), 255};
+            ImageDrawRectangle(&heatmap, direction * HEATMAP_CELL_SIZE, (HEATMAP_POWERS - 1 - power) * HEATMAP_CELL_SIZE,
+                               HEATMAP_CELL_SIZE, HEATMAP_CELL_SIZE, color);
+        }
+    }
+
+    bool exported = ExportImage(heatmap, path);
+    UnloadImage(heatmap);
+
+    return exported;
+}
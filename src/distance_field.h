@@ -0,0 +1,262 @@
+// Signed distance from the walls of a stage, sampled on a regular grid of nodes and
+// interpolated bilinearly in between: negative inside a wall, clamped to a band around
+// them. The field is baked once per level when its assets are built, and cached on disk
+// (see GetCacheFilePath()) so later runs only read it back.
+// Walls never move, so one lookup tells how far a ball is from every wall at once. The
+// physics uses it as a conservative bound (see GetWallClearance()): a ball clear of the
+// walls skips the contact search and moves without sweeping, and only balls close to a
+// wall run the exact per wall tests, so results do not depend on the field resolution.
+#define DISTANCE_FIELD_MAGIC 0x46444D50 // "PMDF"
+#define DISTANCE_FIELD_VERSION 1
+#define DISTANCE_FIELD_CELL_SIZE 4.0f    // px between nodes, coarser only for stages over the node limit
+#define DISTANCE_FIELD_MAX_NODES (1 << 22)
+#define DISTANCE_FIELD_BAND 64.0f        // px, distances are clamped to this
+#define DISTANCE_FIELD_SLACK 1.5f        // Cells, bounds the interpolation error (one cell diagonal) with room for rounding
+
+typedef struct DistanceField
+{
+    Vector2 origin; // Position of the first node
+    float cellSize;
+    int columns; // Nodes per row
+    int rows;
+    float *distance; // Row major node distances, NULL when the stage has no field
+    unsigned int wallHash; // Geometry the field was baked from
+} DistanceField;
+
+// Hash of the wall shapes a field depends on, a cached field is only reused on a match
+unsigned int GetWallGeometryHash(const StageWall *walls, int wallCount)
+{
+    unsigned int hash = HASH_BASIS;
+    float parameters[3] = {DISTANCE_FIELD_CELL_SIZE, DISTANCE_FIELD_BAND, (float)DISTANCE_FIELD_MAX_NODES};
+    hash = HashBytes(hash, parameters, sizeof(parameters));
+
+    for (int i = 0; i < wallCount; i++)
+    {
+        hash = HashBytes(hash, &walls[i].type, sizeof(walls[i].type));
+        for (int vertex = 0; vertex < GetStageWallVertexCount(&walls[i]); vertex++)
+        {
+            Vector2 point = GetStageWallVertex(&walls[i], vertex);
+            hash = HashBytes(hash, &point, sizeof(point));
+        }
+    }
+    return hash;
+}
+
+static float GetSegmentDistance(Vector2 point, Vector2 a, Vector2 b)
+{
+    Vector2 edge = Vector2Subtract(b, a);
+    float t = Clamp(Vector2DotProduct(Vector2Subtract(point, a), edge) / Vector2DotProduct(edge, edge), 0.0f, 1.0f);
+    return Vector2Distance(point, Vector2Add(a, Vector2Scale(edge, t)));
+}
+
+// Signed distance from a point to one wall, negative inside
+float GetWallDistance(const StageWall *wall, Vector2 point)
+{
+    if (wall->type == WALL_EDGE)
+    {
+        return GetSegmentDistance(point, wall->polygon->vertices[0], wall->polygon->vertices[1]);
+    }
+
+    if (wall->type == WALL_POLYGON)
+    {
+        const WallPolygon *polygon = wall->polygon;
+        float separation = -INFINITY;
+        for (int i = 0; i < polygon->vertexCount; i++)
+        {
+            separation = fmaxf(separation, Vector2DotProduct(polygon->normals[i], Vector2Subtract(point, polygon->vertices[i])));
+        }
+        if (separation <= 0)
+        {
+            return separation;
+        }
+
+        float distance = INFINITY;
+        for (int i = 0; i < polygon->vertexCount; i++)
+        {
+            distance = fminf(distance, GetSegmentDistance(point, polygon->vertices[i], polygon->vertices[(i + 1) % polygon->vertexCount]));
+        }
+        return distance;
+    }
+
+    float c = wall->axis.x;
+    float s = wall->axis.y;
+    Vector2 delta = Vector2Subtract(point, wall->position);
+    float outsideX = fabsf(c * delta.x + s * delta.y) - wall->halfExtents.x;
+    float outsideY = fabsf(-s * delta.x + c * delta.y) - wall->halfExtents.y;
+
+    return Vector2Length((Vector2){fmaxf(outsideX, 0), fmaxf(outsideY, 0)}) + fminf(fmaxf(outsideX, outsideY), 0);
+}
+
+// Bake the field of a set of walls. Each wall only visits the nodes within the band of
+// its bounds, keeping the smallest distance, so the cost follows the wall area rather
+// than the stage area times the wall count. Stages too big for the node limit get
+// coarser cells.
+DistanceField BakeDistanceField(const StageWall *walls, int wallCount)
+{
+    DistanceField field = {0};
+    field.wallHash = GetWallGeometryHash(walls, wallCount);
+    if (wallCount == 0)
+    {
+        return field;
+    }
+
+    Rectangle bounds = walls[0].bounds;
+    for (int i = 1; i < wallCount; i++)
+    {
+        float right = fmaxf(bounds.x + bounds.width, walls[i].bounds.x + walls[i].bounds.width);
+        float bottom = fmaxf(bounds.y + bounds.height, walls[i].bounds.y + walls[i].bounds.height);
+        bounds.x = fminf(bounds.x, walls[i].bounds.x);
+        bounds.y = fminf(bounds.y, walls[i].bounds.y);
+        bounds.width = right - bounds.x;
+        bounds.height = bottom - bounds.y;
+    }
+
+    field.origin = (Vector2){bounds.x - DISTANCE_FIELD_BAND, bounds.y - DISTANCE_FIELD_BAND};
+    float width = bounds.width + DISTANCE_FIELD_BAND * 2.0f;
+    float height = bounds.height + DISTANCE_FIELD_BAND * 2.0f;
+    field.cellSize = DISTANCE_FIELD_CELL_SIZE;
+    while ((ceilf(width / field.cellSize) + 1) * (ceilf(height / field.cellSize) + 1) > DISTANCE_FIELD_MAX_NODES)
+    {
+        field.cellSize += 1.0f;
+    }
+    field.columns = (int)ceilf(width / field.cellSize) + 1;
+    field.rows = (int)ceilf(height / field.cellSize) + 1;
+    field.distance = (float *)malloc(field.columns * field.rows * sizeof(float));
+    for (int i = 0; i < field.columns * field.rows; i++)
+    {
+        field.distance[i] = DISTANCE_FIELD_BAND;
+    }
+
+    for (int i = 0; i < wallCount; i++)
+    {
+        Rectangle area = walls[i].bounds;
+        int x0 = (int)floorf((area.x - DISTANCE_FIELD_BAND - field.origin.x) / field.cellSize);
+        int x1 = (int)ceilf((area.x + area.width + DISTANCE_FIELD_BAND - field.origin.x) / field.cellSize);
+        int y0 = (int)floorf((area.y - DISTANCE_FIELD_BAND - field.origin.y) / field.cellSize);
+        int y1 = (int)ceilf((area.y + area.height + DISTANCE_FIELD_BAND - field.origin.y) / field.cellSize);
+        x0 = (x0 < 0) ? 0 : x0;
+        y0 = (y0 < 0) ? 0 : y0;
+        x1 = (x1 >= field.columns) ? field.columns - 1 : x1;
+        y1 = (y1 >= field.rows) ? field.rows - 1 : y1;
+
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                Vector2 node = {field.origin.x + x * field.cellSize, field.origin.y + y * field.cellSize};
+                float *distance = &field.distance[y * field.columns + x];
+                *distance = fminf(*distance, GetWallDistance(&walls[i], node));
+            }
+        }
+    }
+
+    return field;
+}
+
+void FreeDistanceField(DistanceField *field)
+{
+    free(field->distance);
+    *field = (DistanceField){0};
+}
+
+// Read a field cached by SaveDistanceField(). Fails when the file is missing, damaged, or
+// was baked from other walls (wallHash), the caller bakes a new one then.
+bool LoadDistanceField(const char *path, unsigned int wallHash, DistanceField *field)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    unsigned int header[3];
+    DistanceField loaded = {0};
+    bool valid = fread(header, sizeof(header), 1, file) == 1 && header[0] == DISTANCE_FIELD_MAGIC &&
+                 header[1] == DISTANCE_FIELD_VERSION && header[2] == wallHash &&
+                 fread(&loaded.origin, sizeof(loaded.origin), 1, file) == 1 &&
+                 fread(&loaded.cellSize, sizeof(loaded.cellSize), 1, file) == 1 &&
+                 fread(&loaded.columns, sizeof(loaded.columns), 1, file) == 1 &&
+                 fread(&loaded.rows, sizeof(loaded.rows), 1, file) == 1 && loaded.columns > 0 && loaded.rows > 0 &&
+                 loaded.columns <= DISTANCE_FIELD_MAX_NODES / loaded.rows;
+
+    if (valid)
+    {
+        int count = loaded.columns * loaded.rows;
+        loaded.distance = (float *)malloc(count * sizeof(float));
+        valid = fread(loaded.distance, sizeof(float), count, file) == (size_t)count;
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        free(loaded.distance);
+        return false;
+    }
+
+    loaded.wallHash = wallHash;
+    *field = loaded;
+    return true;
+}
+
+// Cache a field on disk, in the byte order of the machine (a file from another one fails
+// the magic check and is baked again)
+bool SaveDistanceField(const char *path, const DistanceField *field)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "FIELD: Could not cache the distance field to %s", path);
+        return false;
+    }
+
+    unsigned int header[3] = {DISTANCE_FIELD_MAGIC, DISTANCE_FIELD_VERSION, field->wallHash};
+    int count = field->columns * field->rows;
+    bool written = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(&field->origin, sizeof(field->origin), 1, file) == 1 &&
+                   fwrite(&field->cellSize, sizeof(field->cellSize), 1, file) == 1 &&
+                   fwrite(&field->columns, sizeof(field->columns), 1, file) == 1 &&
+                   fwrite(&field->rows, sizeof(field->rows), 1, file) == 1 &&
+                   fwrite(field->distance, sizeof(float), count, file) == (size_t)count;
+    fclose(file);
+
+    if (!written)
+    {
+        TraceLog(LOG_WARNING, "FIELD: Could not cache the distance field to %s", path);
+        remove(path);
+    }
+    return written;
+}
+
+// Interpolated signed distance at a point. Points outside the field get -INFINITY: unknown.
+float SampleDistanceField(const DistanceField *field, Vector2 point)
+{
+    if (field->distance == NULL)
+    {
+        return -INFINITY;
+    }
+
+    float fx = (point.x - field->origin.x) / field->cellSize;
+    float fy = (point.y - field->origin.y) / field->cellSize;
+    int x = (int)floorf(fx);
+    int y = (int)floorf(fy);
+    if (x < 0 || y < 0 || x >= field->columns - 1 || y >= field->rows - 1)
+    {
+        return -INFINITY;
+    }
+
+    float tx = fx - x;
+    float ty = fy - y;
+    const float *row = &field->distance[y * field->columns + x];
+    float d00 = row[0];
+    float d10 = row[1];
+    float d01 = row[field->columns];
+    float d11 = row[field->columns + 1];
+
+    return (d00 * (1 - tx) + d10 * tx) * (1 - ty) + (d01 * (1 - tx) + d11 * tx) * ty;
+}
+
+// How far a circle can move in any direction without touching a wall, never more than
+// the real distance. Zero or less when it may touch one, or when the field cannot tell.
+float GetWallClearance(const DistanceField *field, Vector2 center, float radius)
+{
+    return SampleDistanceField(field, center) - field->cellSize * DISTANCE_FIELD_SLACK - radius;
+}
@@ -0,0 +1,110 @@
+#define MAX_SHOT_EVENTS 256 // Wall impacts before a shot is given up, a ball wedged between walls never stops bouncing
+
+// Shot outcome computed from one wall impact to the next instead of tick by tick. With
+// no gravity and a constant rolling deceleration the ball moves in straight lines
+// between impacts, and how far it still rolls follows from its speed alone, so each
+// event sweeps the whole remaining path through the wall grid, stops at the first
+// impact, bounces, and goes on with the speed left at that point. A shot costs one sweep
+// per bounce whatever its length.
+// The stepped simulation integrates the same motion in substeps, so both agree up to the
+// integration error (a few px over a full shot), which only matters for shots that
+// stop right at the goal edge. The solver cross-checks them with -c.
+// The stage is only read, so any number of threads can share it. AdvanceShotEvent runs
+// one event at a time for callers that spread a shot over several frames.
+typedef struct ShotEventState
+{
+    Vector2 position;
+    Vector2 velocity;
+    float timeLeft; // ms
+    int events;
+    ShotResult result; // SHOT_IN_PROGRESS until the ball rests, also after a timeout
+    bool finished;
+} ShotEventState;
+
+ShotEventState BeginShotEvents(Vector2 position, Vector2 directionVector)
+{
+    return (ShotEventState){position, GetLaunchVelocity(directionVector), MAX_SHOT_TICKS * SIMULATION_TICK, 0,
+                            SHOT_IN_PROGRESS, false};
+}
+
+// Move the ball to its next wall impact, or to where the shot ends. Returns false once the
+// shot is over, state->position is then the rest position.
+bool AdvanceShotEvent(const StageData *stage, ShotEventState *state)
+{
+    const BodyStore *bodies = &stage->world.bodies;
+    BodyDamping damping = bodies->damping[stage->ball];
+    float radius = bodies->radius[stage->ball];
+
+    if (state->finished || state->events >= MAX_SHOT_EVENTS)
+    {
+        state->finished = true;
+        return false;
+    }
+
+    float speed = Vector2Length(state->velocity);
+    if (speed <= damping.restSpeed)
+    {
+        state->result = (Vector2Distance(state->position, stage->goalPosition) < GOAL_RADIUS) ? SHOT_GOAL : SHOT_MISS;
+        state->finished = true;
+        return false;
+    }
+
+    // Path until the ball stops, or until the shot runs out of time
+    float stopTime = (damping.deceleration > 0) ? (speed - damping.restSpeed) / damping.deceleration : INFINITY;
+    float travelTime = fminf(stopTime, state->timeLeft);
+    float distance = speed * travelTime - 0.5f * damping.deceleration * travelTime * travelTime;
+    Vector2 displacement = Vector2Scale(state->velocity, distance / speed);
+    float timeOfImpact;
+    Vector2 normal;
+    const StageWall *wall;
+
+    if (!SweepWalls(&stage->world.wallGrid, stage->world.walls, state->position, radius, displacement, &timeOfImpact, &normal,
+                    &wall))
+    {
+        state->position = Vector2Add(state->position, displacement);
+        if (travelTime == stopTime)
+        {
+            state->result = (Vector2Distance(state->position, stage->goalPosition) < GOAL_RADIUS) ? SHOT_GOAL : SHOT_MISS;
+        }
+        state->finished = true;
+        return false;
+    }
+
+    // Time and speed at the impact, from distance = speed * t - deceleration * t^2 / 2
+    float travelled = distance * timeOfImpact;
+    float impactTime = (damping.deceleration > 0)
+                           ? (speed - sqrtf(fmaxf(speed * speed - 2.0f * damping.deceleration * travelled, 0))) / damping.deceleration
+                           : travelled / speed;
+    state->position = Vector2Add(state->position, Vector2Scale(displacement, timeOfImpact));
+    state->velocity = Vector2Scale(state->velocity, (speed - damping.deceleration * impactTime) / speed);
+    state->timeLeft -= impactTime;
+    state->events++;
+
+    float contactVelocity = Vector2DotProduct(state->velocity, normal);
+    if (contactVelocity < 0)
+    {
+        float restitution = sqrtf(bodies->restitution[stage->ball] * wall->restitution);
+        state->velocity = Vector2Add(state->velocity, Vector2Scale(normal, -(1.0f + restitution) * contactVelocity));
+    }
+
+    return true;
+}
+
+ShotResult SimulateShotEvents(const StageData *stage, Vector2 directionVector, Vector2 *restPosition, int *eventCount)
+{
+    ShotEventState state = BeginShotEvents(stage->initialPlayerPosition, directionVector);
+    while (AdvanceShotEvent(stage, &state))
+    {
+    }
+
+    if (restPosition != NULL)
+    {
+        *restPosition = state.position;
+    }
+    if (eventCount != NULL)
+    {
+        *eventCount = state.events;
+    }
+
+    return state.result;
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+
+// Runs scripted launches without a window, as fast as the CPU allows.
+// Each non-comment line of the script is "<level> <dragX> <dragY>", where the drag
+// vector is ball - cursor at release time, exactly as UpdateBall computes it.
+int RunHeadless(const char *scriptPath)
+{
+    FILE *script = (strcmp(scriptPath, "-") == 0) ? stdin : fopen(scriptPath, "r");
+    if (script == NULL)
+    {
+        fprintf(stderr, "Could not open shot script %s\n", scriptPath);
+        return 1;
+    }
+
+    StageData stage = {0};
+    ShotCache cache = {0};
+    unsigned int stageKey = 0;
+    int shots = 0;
+    int goals = 0;
+    long totalTicks = 0;
+    double start = GetMonotonicTime();
+
+    char line[256];
+    while (fgets(line, sizeof(line), script) != NULL)
+    {
+        int level;
+        Vector2 directionVector;
+        if (line[0] == '#' || sscanf(line, "%d %f %f", &level, &directionVector.x, &directionVector.y) != 3)
+        {
+            continue;
+        }
+
+        if (stage.map == NULL || stage.level != level)
+        {
+            ReloadStage(&stage, level);
+            stageKey = GetShotCacheStageKey(&stage);
+        }
+
+        // Scripts often repeat a launch, only the first one is simulated
+        ShotOutcome outcome = GetShotOutcome(&cache, &stage, stageKey, directionVector);
+        ShotResult result = outcome.result;
+
+        shots++;
+        totalTicks += outcome.ticks;
+        if (result == SHOT_GOAL)
+        {
+            goals++;
+        }
+
+        printf("level %d launch (%.2f, %.2f): %s at (%.2f, %.2f) after %d ticks\n", stage.level,
+               directionVector.x, directionVector.y,
+               (result == SHOT_GOAL) ? "goal" : (result == SHOT_MISS) ? "miss" : "timeout",
+               outcome.restPosition.x, outcome.restPosition.y, outcome.ticks);
+    }
+
+    double elapsed = GetMonotonicTime() - start;
+    printf("%d shots (%d simulated), %d goals, %ld ticks in %.3f s (%.0f shots/s)\n", shots, cache.misses, goals,
+           totalTicks, elapsed, (elapsed > 0) ? shots / elapsed : 0.0);
+
+    FreeShotCache(&cache);
+    FreeStage(&stage);
+    UnloadStages();
+
+    if (script != stdin)
+    {
+        fclose(script);
+    }
+
+    return 0;
+}
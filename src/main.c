@@ -1,20 +1,36 @@
 #include "raylib.h"
 #include "raymath.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
 #endif
 
-#define PHYSAC_IMPLEMENTATION
-#include "extras/physac.h"
-
 #define CUTE_TILED_IMPLEMENTATION
 #include "cute_tiled.h"
 
-#define GOAL_RADIUS 50.0f
-#define PLAYER_RADIUS 15.0f
-
+#include "binary_io.h"
+#include "body_store.h"
+#include "physics_stats.h"
+#include "wall_polygon.h"
+#include "stage_collision.h"
+#include "wall_merge.h"
+#include "wall_batch.h"
+#include "distance_field.h"
+#include "timer.h"
+#include "physics_world.h"
+#include "cache_directory.h"
 #include "stage_loader.h"
+#include "simulation.h"
+#include "event_simulation.h"
+#include "trajectory_preview.h"
+#include "shot_cache.h"
+#include "headless.h"
+#include "replay.h"
+#if defined(PHYSICS_THREAD)
+#include "physics_thread.h"
+#endif
 
 //----------------------------------------------------------------------------------
 // Global Variables Definition
@@ -23,6 +39,16 @@ int screenWidth = 896;
 int screenHeight = 504;
 
 StageData stage;
+TrajectoryPreview preview;
+SimulationClock simulationClock; // Rendered time not simulated yet
+float renderAlpha = 0.0f;         // Where the drawn frame sits between the last two ticks
+PhysicsStats physicsStats;        // Counters of the ticks simulated this frame
+bool showPhysicsStats = false;    // F3 toggles the overlay
+FILE *replayFile = NULL; // Session recording, NULL when not recording
+#if defined(PHYSICS_THREAD)
+PhysicsThread physicsThread;
+bool physicsThreaded = false; // The simulation runs on physicsThread, stage only mirrors it
+#endif
 
 //----------------------------------------------------------------------------------
 // Module Functions Declaration
@@ -31,23 +57,67 @@ void UpdateDrawFrame(); // Update and Draw one frame
 void DrawMouseWidget(Vector2 pos, Color color);
 void DrawBodies();
 void UpdateBall();
+void UpdateSimulation(FrameInput input);
 
 //----------------------------------------------------------------------------------
 // Main Enry Point
 //----------------------------------------------------------------------------------
-int main()
+int main(int argc, char **argv)
 {
+    // Headless mode: simulate scripted shots without opening a window
+    if (argc >= 3 && strcmp(argv[1], "--headless") == 0)
+    {
+        return RunHeadless(argv[2]);
+    }
+
+    // Play a recorded session back without a window, checking it is reproduced exactly
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+    {
+        return RunReplay(argv[2]);
+    }
+
+    const char *replayPath = "session.replay";
+    bool usePhysicsThread = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--physics-thread") == 0)
+        {
+            usePhysicsThread = true;
+        }
+    }
+
     // Initialization
     //--------------------------------------------------------------------------------------
     InitWindow(screenWidth, screenHeight, "Momentum Primal");
 
     HideCursor();
 
-    // Initialize physics and default physics bodies
-    InitPhysics();
-    SetPhysicsTimeStep(1.0 / 60.0 / 100 * 1000); // 0.16ms
-
+    PreloadStages();
     stage = LoadStage(1);
+    stage.world.stats = &physicsStats;
+
+#if !defined(PLATFORM_WEB)
+    replayFile = OpenReplayRecording(replayPath, stage.level);
+#else
+    (void)replayPath;
+#endif
+
+#if defined(PHYSICS_THREAD)
+    // The physics thread simulates its own copy of the stage
+    if (usePhysicsThread)
+    {
+        physicsThreaded = StartPhysicsThread(&physicsThread, &stage, replayFile);
+    }
+#else
+    if (usePhysicsThread)
+    {
+        TraceLog(LOG_WARNING, "The physics thread is not available in this build");
+    }
+#endif
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
@@ -64,9 +134,18 @@ int main()
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
-    ClosePhysics(); // Unitialize physics
-    CloseWindow();  // Close window and OpenGL context
+#if defined(PHYSICS_THREAD)
+    if (physicsThreaded)
+    {
+        StageData simulated = StopPhysicsThread(&physicsThread);
+        FreeStage(&simulated);
+    }
+#endif
+    CloseReplayRecording(replayFile);
+    CloseWindow(); // Close window and OpenGL context
+    FreeTrajectoryPreview(&preview);
     FreeStage(&stage);
+    UnloadStages();
     //--------------------------------------------------------------------------------------
 
     return 0;
@@ -82,18 +161,7 @@ void UpdateDrawFrame()
 
     // Update
     //----------------------------------------------------------------------------------
-    UpdatePhysics(); // Update physics system
     UpdateBall();
-    if (IsKeyPressed(KEY_R))
-    {
-        FreeStage(&stage);
-        stage = LoadStage(stage.level);
-    }
-    if (IsKeyPressed(KEY_N))
-    {
-        FreeStage(&stage);
-        stage = LoadStage(stage.level + 1);
-    }
     //----------------------------------------------------------------------------------
 
     // Draw
@@ -103,6 +171,10 @@ void UpdateDrawFrame()
     ClearBackground(RAYWHITE);
 
     DrawFPS(screenWidth - 90, screenHeight - 30);
+    if (showPhysicsStats)
+    {
+        DrawPhysicsStats(&physicsStats, screenWidth - 270, screenHeight - 26, DARKGRAY);
+    }
 
     DrawBodies();
 
@@ -133,29 +205,32 @@ void UpdateDrawFrame()
 
 void UpdateBall()
 {
-    PhysicsBody ball = stage.ball;
+#if defined(PHYSICS_THREAD)
+    if (physicsThreaded)
+    {
+        renderAlpha = ReadPhysicsSnapshot(&physicsThread, &stage);
+    }
+#endif
+
     Vector2 mousePos = GetMousePosition();
+    FrameInput input = {.frameTime = GetFrameTime()};
 
-    Vector2 ballPosition = ball->position;
-    Vector2 velocity = ball->velocity;
-    float speed = Vector2Length(velocity);
+    Vector2 ballPosition = stage.world.bodies.position[stage.ball];
+    float speed = Vector2Length(stage.world.bodies.velocity[stage.ball]);
     if (speed == 0)
     {
-        Vector2 directionVector = {(ball->position.x - mousePos.x), (ball->position.y - mousePos.y)};
-        float maxDistanceLaunch = 100.0f;
-        float lengthDirectionVector = Vector2Length(directionVector);
+        Vector2 directionVector = {(ballPosition.x - mousePos.x), (ballPosition.y - mousePos.y)};
 
         if (IsMouseButtonDown(0))
         {
-            Vector2 launchVector = directionVector;
-            if (lengthDirectionVector > maxDistanceLaunch)
-            {
-                launchVector = Vector2Scale(Vector2Normalize(launchVector), maxDistanceLaunch);
-            }
+            UpdateTrajectoryPreview(&preview, &stage, directionVector);
+            DrawTrajectoryPreview(&preview, GRAY);
+
+            Vector2 launchVector = GetLaunchVector(directionVector);
 
             Vector2 endPosition = Vector2Add(ballPosition, launchVector);
             // void DrawLine(int startPosX, int startPosY, int endPosX, int endPosY, Color color);
-            float greenComponent = Remap(Vector2Length(launchVector), 0, maxDistanceLaunch, 255, 0);
+            float greenComponent = Remap(Vector2Length(launchVector), 0, MAX_LAUNCH_DISTANCE, 255, 0);
             Color launchColor = (Color){255, greenComponent, 0, 255};
             DrawLine(ballPosition.x, ballPosition.y, endPosition.x, endPosition.y, launchColor);
         }
@@ -164,41 +239,30 @@ void UpdateBall()
         {
             // calculate direction ball - mouse and power (distance)
             // shoot
-
-            float launchSpeed = Remap(lengthDirectionVector, 0, maxDistanceLaunch, 0, 0.5f);
-            launchSpeed = Clamp(launchSpeed, 0, 0.5f);
-
-            directionVector = Vector2Normalize(directionVector);
-
-            directionVector = Vector2Scale(directionVector, launchSpeed);
-
-            ball->velocity = directionVector;
-            stage.launched = true;
+            input.launch = true;
+            input.launchVector = directionVector;
+            preview.active = false;
         }
     }
-    else
+
+    if (IsKeyPressed(KEY_R))
     {
-        if (speed <= 0.005f)
-        {
-            ball->velocity = (Vector2){0, 0};
-        }
-        else
-        {
-            Vector2 oppositeDirection = velocity;
-            oppositeDirection.x = -oppositeDirection.x;
-            oppositeDirection.y = -oppositeDirection.y;
-            oppositeDirection = Vector2Normalize(oppositeDirection);
-            float deceleration = GetFrameTime() * 0.06f; // a * t
-            oppositeDirection = Vector2Scale(oppositeDirection, deceleration);
-
-            ball->velocity = Vector2Add(ball->velocity, oppositeDirection);
-        }
+        input.stageRequest = stage.level;
+    }
+    if (IsKeyPressed(KEY_N))
+    {
+        input.stageRequest = stage.level + 1;
+    }
+    if (IsKeyPressed(KEY_F3))
+    {
+        showPhysicsStats = !showPhysicsStats;
     }
 
-    speed = Vector2Length(ball->velocity);
+    UpdateSimulation(input);
 
     // Goal condition
-    if (speed == 0 && Vector2Distance(ball->position, stage.goalPosition) < GOAL_RADIUS)
+    if (Vector2Length(stage.world.bodies.velocity[stage.ball]) == 0 &&
+        Vector2Distance(stage.world.bodies.position[stage.ball], stage.goalPosition) < GOAL_RADIUS)
     {
         stage.goalReached = true;
         stage.goalReachedAt = GetTime();
@@ -211,23 +275,31 @@ void UpdateBall()
         FreeStage(&stage);
         LoadStage(stage.level + 1);
     }*/
-    if (stage.launched)
+}
+
+// Simulate the fixed ticks due this frame, or hand the input to the physics thread
+void UpdateSimulation(FrameInput input)
+{
+#if defined(PHYSICS_THREAD)
+    if (physicsThreaded)
     {
-        if (speed == 0)
-        {
-            if (Vector2Distance(ball->position, stage.goalPosition) < GOAL_RADIUS)
-            {
-                stage.goalReached = true;
-                FreeStage(&stage);
-                stage = LoadStage(stage.level + 1);
-            }
-            else
-            {
-                ball->position = stage.initialPlayerPosition;
-            }
-            stage.launched = false;
-        }
+        PostPhysicsInput(&physicsThread, input);
+        return;
     }
+#endif
+
+    ResetPhysicsStats(&physicsStats);
+    ApplyFrameInput(&stage, input);
+    RecordReplayInput(replayFile, input);
+
+    // The simulation runs fixed ticks, however long the rendered frame took
+    for (int ticks = AdvanceSimulationClock(&simulationClock, input.frameTime); ticks > 0; ticks--)
+    {
+        UpdateStageTick(&stage);
+        RecordReplayTick(replayFile, GetStageChecksum(&stage));
+    }
+
+    renderAlpha = GetSimulationClockAlpha(&simulationClock);
 }
 
 void DrawBodies()
@@ -236,29 +308,34 @@ void DrawBodies()
     DrawCircle(stage.goalPosition.x, stage.goalPosition.y, GOAL_RADIUS, GREEN);
     DrawCircleLines(stage.goalPosition.x, stage.goalPosition.y, GOAL_RADIUS, DARKGRAY);
 
-    DrawCircle(stage.ball->position.x, stage.ball->position.y, PLAYER_RADIUS, GRAY);
+    // Bodies are drawn between their last two tick states, so motion stays smooth at any
+    // render rate
+    Vector2 ballPosition = GetInterpolatedBodyPosition(&stage.world.bodies, stage.ball, renderAlpha);
+    DrawCircle(ballPosition.x, ballPosition.y, PLAYER_RADIUS, GRAY);
 
-    int bodiesCount = GetPhysicsBodiesCount();
-    for (int i = 0; i < bodiesCount; i++)
+    for (int i = 0; i < stage.world.wallCount; i++)
     {
-        PhysicsBody body = GetPhysicsBody(i);
+        const StageWall *wall = &stage.world.walls[i];
+        int vertexCount = GetStageWallVertexCount(wall);
 
-        if (body != NULL)
+        // Boxes and polygon pieces are closed outlines, an edge is a single line
+        int lineCount = (wall->type == WALL_EDGE) ? 1 : vertexCount;
+        for (int j = 0; j < lineCount; j++)
         {
-            int vertexCount = GetPhysicsShapeVerticesCount(i);
-            for (int j = 0; j < vertexCount; j++)
-            {
-                // Get physics bodies shape vertices to draw lines
-                // Note: GetPhysicsShapeVertex() already calculates rotation transformations
-                Vector2 vertexA = GetPhysicsShapeVertex(body, j);
-
-                int jj = (((j + 1) < vertexCount) ? (j + 1) : 0); // Get next vertex or first to close the shape
-                Vector2 vertexB = GetPhysicsShapeVertex(body, jj);
-
-                DrawLineV(vertexA, vertexB, DARKGRAY); // Draw a line between two vertex positions
-            }
+            Vector2 vertexA = GetStageWallVertex(wall, j);
+            Vector2 vertexB = GetStageWallVertex(wall, (j + 1) % vertexCount);
+
+            DrawLineV(vertexA, vertexB, DARKGRAY);
         }
     }
+
+    const BodyStore *bodies = &stage.world.bodies;
+    for (BodyHandle body = 0; body < bodies->count; body++)
+    {
+        // Body outlines, rotated with the body orientation
+        DrawPolyLines(GetInterpolatedBodyPosition(bodies, body, renderAlpha), BODY_OUTLINE_SIDES, bodies->radius[body],
+                      GetInterpolatedBodyOrient(bodies, body, renderAlpha) * RAD2DEG, DARKGRAY);
+    }
 }
 
 void DrawMouseWidget(Vector2 pos, Color color)
@@ -0,0 +1,115 @@
+// Many bodies of one world stepped on every core. Bodies never collide with each other
+// and the walls never move, so each body only reads the shared colliders and writes its
+// own state: the body store is cut into groups of consecutive bodies (contiguous in every
+// array of the store), and workers pull whole groups. A group runs all the ticks of a
+// call for one body before the next, so a body stays in cache while it moves and each
+// call costs a single fork and join. Every body picks its own substeps, so it moves
+// exactly as it would alone in the world (see GetBodySubsteps()).
+#define BODY_GROUP_SIZE 64 // Bodies per task, small enough to balance bodies that stop early
+
+// Scratch of one group, so groups never share a contact list or cache
+typedef struct BodyGroup
+{
+    WallContactList contacts;
+    ContactCache contactCache;
+    PhysicsStats stats;
+} BodyGroup;
+
+typedef struct BodyGroups
+{
+    int count;
+    BodyGroup *groups;
+} BodyGroups;
+
+typedef struct BodyGroupJob
+{
+    PhysicsWorld *world;
+    BodyGroups *groups;
+    float tickTime;
+    int tickCount;
+} BodyGroupJob;
+
+static void StepBodyGroup(int index, void *userData)
+{
+    BodyGroupJob *job = (BodyGroupJob *)userData;
+    PhysicsWorld *world = job->world;
+    BodyStore *bodies = &world->bodies;
+    BodyGroup *group = &job->groups->groups[index];
+    PhysicsStats *stats = (world->stats != NULL) ? &group->stats : NULL;
+    BodyHandle first = index * BODY_GROUP_SIZE;
+    BodyHandle last = (first + BODY_GROUP_SIZE < bodies->count) ? first + BODY_GROUP_SIZE : bodies->count;
+
+    group->stats = (PhysicsStats){0};
+
+    for (BodyHandle body = first; body < last; body++)
+    {
+        // Warm starting begins again with each body, the cache only ever holds its contacts
+        group->contactCache.count = 0;
+
+        for (int tick = 0; tick < job->tickCount; tick++)
+        {
+            bodies->previousPosition[body] = bodies->position[body];
+            bodies->previousOrient[body] = bodies->orient[body];
+
+            int substeps = GetBodySubsteps(world, body, job->tickTime);
+            if (substeps == 0)
+            {
+                break;
+            }
+
+            group->stats.steps += substeps;
+            for (int i = 0; i < substeps; i++)
+            {
+                BeginContactCacheStep(&group->contactCache);
+                StepPhysicsBodies(world, body, body + 1, job->tickTime / substeps, &group->contacts, &group->contactCache, stats);
+            }
+        }
+    }
+}
+
+// Advance every body of a world by tickCount ticks (ms each) on up to workerCount
+// threads. The groups keep their scratch buffers from one call to the next.
+void StepBodiesParallel(PhysicsWorld *world, BodyGroups *groups, float tickTime, int tickCount, int workerCount)
+{
+    int groupCount = (world->bodies.count + BODY_GROUP_SIZE - 1) / BODY_GROUP_SIZE;
+    if (groupCount > groups->count)
+    {
+        groups->groups = (BodyGroup *)realloc(groups->groups, groupCount * sizeof(BodyGroup));
+        memset(&groups->groups[groups->count], 0, (groupCount - groups->count) * sizeof(BodyGroup));
+        groups->count = groupCount;
+    }
+
+    BodyGroupJob job = {world, groups, tickTime, tickCount};
+    RunParallelOn(workerCount, groupCount, StepBodyGroup, &job);
+
+    if (world->stats != NULL)
+    {
+        PhysicsStats *stats = world->stats;
+        stats->ticks += tickCount;
+        for (int i = 0; i < groupCount; i++)
+        {
+            const PhysicsStats *groupStats = &groups->groups[i].stats;
+            stats->steps += groupStats->steps;
+            stats->broadphasePairs += groupStats->broadphasePairs;
+            stats->manifolds += groupStats->manifolds;
+            stats->contactPoints += groupStats->contactPoints;
+            stats->solverIterations += groupStats->solverIterations;
+            stats->contactTime += groupStats->contactTime;
+            stats->solveTime += groupStats->solveTime;
+            stats->sweepTime += groupStats->sweepTime;
+            stats->droppedSweepTime += groupStats->droppedSweepTime;
+            stats->correctTime += groupStats->correctTime;
+        }
+    }
+}
+
+void FreeBodyGroups(BodyGroups *groups)
+{
+    for (int i = 0; i < groups->count; i++)
+    {
+        FreeWallContactList(&groups->groups[i].contacts);
+        FreeContactCache(&groups->groups[i].contactCache);
+    }
+    free(groups->groups);
+    *groups = (BodyGroups){0};
+}
@@ -0,0 +1,38 @@
+// Counters filled by the physics step, to tell at a glance whether a slow frame comes
+// from the simulation. Collection is off for stages without a stats pointer (solver,
+// headless runs, trajectory preview ghosts), so the timers cost nothing there.
+typedef struct PhysicsStats
+{
+    int ticks;            // Fixed ticks run
+    int steps;            // Substeps run
+    int broadphasePairs;  // Body and wall pairs handed to the narrowphase
+    int manifolds;        // Wall contacts created
+    int contactPoints;    // Contact points resolved, discrete and swept
+    int solverIterations; // Velocity solver passes
+
+    // Motion (ms) left unswept after MAX_SWEEP_ITERATIONS impacts in one substep, see SweepBall()
+    float droppedSweepTime;
+
+    // Microseconds per phase
+    float contactTime; // Broadphase and narrowphase
+    float solveTime;   // Contact impulses
+    float sweepTime;   // Continuous integration against the walls
+    float correctTime; // Position correction and damping
+} PhysicsStats;
+
+void ResetPhysicsStats(PhysicsStats *stats)
+{
+    *stats = (PhysicsStats){0};
+}
+
+// Draw the counters as a column of text whose bottom line sits at y
+void DrawPhysicsStats(const PhysicsStats *stats, int x, int y, Color color)
+{
+    DrawText(TextFormat("ticks %d, steps %d", stats->ticks, stats->steps), x, y - 48, 10, color);
+    DrawText(TextFormat("pairs %d, manifolds %d", stats->broadphasePairs, stats->manifolds), x, y - 36, 10, color);
+    DrawText(TextFormat("contacts %d, iterations %d, dropped %.2f ms", stats->contactPoints, stats->solverIterations,
+                        stats->droppedSweepTime),
+             x, y - 24, 10, color);
+    DrawText(TextFormat("contact %.1f us, solve %.1f us", stats->contactTime, stats->solveTime), x, y - 12, 10, color);
+    DrawText(TextFormat("sweep %.1f us, correct %.1f us", stats->sweepTime, stats->correctTime), x, y, 10, color);
+}
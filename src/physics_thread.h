@@ -0,0 +1,202 @@
+// Game simulation on its own thread, ticking at the fixed rate whatever the render loop does.
+// The physics thread owns the simulated stage. After every tick it publishes the bodies
+// into one of two snapshot buffers; the render thread copies the latest one and never
+// waits. While it copies, the render thread claims the buffer, and the physics thread
+// skips publishing a tick rather than write into a claimed buffer, so no buffer is ever
+// read and written at once and snapshots can grow with the stage. Input goes the other
+// way through atomics, and stage loads happen on the physics thread between ticks.
+// Needs POSIX threads and C11 atomics, the build only defines PHYSICS_THREAD where both
+// are available (MinGW and every desktop but MSVC).
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+typedef struct PhysicsSnapshot
+{
+    long tick;
+    double time; // GetMonotonicTime() when the tick was published
+    int level;
+    bool victory;
+    bool launched;
+    BodyStore bodies;
+    PhysicsStats stats; // Counters of the tick that produced the snapshot
+} PhysicsSnapshot;
+
+typedef struct PhysicsThread
+{
+    pthread_t thread;
+    atomic_bool running;
+    StageData stage; // Only touched by the physics thread while it runs
+    PhysicsStats stats; // Counters of the tick being simulated
+    FILE *replayFile;
+
+    PhysicsSnapshot snapshots[2];
+    atomic_int latest;  // Snapshot published last
+    atomic_int reading; // Snapshot the render thread is copying, -1 for none
+
+    // Input posted by the render thread, consumed before the next tick
+    atomic_int stageRequest;
+    atomic_bool launchPending;
+    Vector2 launchVector; // Written only while launchPending is false
+} PhysicsThread;
+
+static void PublishPhysicsSnapshot(PhysicsThread *physics, long tick)
+{
+    int index = 1 - atomic_load(&physics->latest);
+    if (atomic_load(&physics->reading) == index)
+    {
+        return; // Still being copied from, the render thread already has a newer snapshot to read
+    }
+
+    PhysicsSnapshot *snapshot = &physics->snapshots[index];
+    const StageData *stage = &physics->stage;
+
+    snapshot->tick = tick;
+    snapshot->time = GetMonotonicTime();
+    snapshot->level = stage->level;
+    snapshot->victory = stage->victory;
+    snapshot->launched = stage->launched;
+    snapshot->stats = physics->stats;
+    CopyBodyStore(&snapshot->bodies, &stage->world.bodies);
+
+    atomic_store(&physics->latest, index);
+}
+
+static void ApplyPostedInput(PhysicsThread *physics)
+{
+    FrameInput input = {0};
+
+    input.stageRequest = atomic_exchange(&physics->stageRequest, 0);
+    if (atomic_load_explicit(&physics->launchPending, memory_order_acquire))
+    {
+        input.launch = true;
+        input.launchVector = physics->launchVector;
+        atomic_store_explicit(&physics->launchPending, false, memory_order_release);
+    }
+
+    if (input.stageRequest > 0 || input.launch)
+    {
+        ApplyFrameInput(&physics->stage, input);
+        RecordReplayInput(physics->replayFile, input);
+    }
+}
+
+static void *RunPhysicsThread(void *argument)
+{
+    PhysicsThread *physics = (PhysicsThread *)argument;
+    SimulationClock clock = {0};
+    long tick = 0;
+    double previous = GetMonotonicTime();
+
+    while (atomic_load(&physics->running))
+    {
+        double now = GetMonotonicTime();
+        int ticks = AdvanceSimulationClock(&clock, (float)(now - previous));
+        previous = now;
+
+        for (int i = 0; i < ticks; i++)
+        {
+            ResetPhysicsStats(&physics->stats);
+            ApplyPostedInput(physics);
+            UpdateStageTick(&physics->stage);
+            RecordReplayTick(physics->replayFile, GetStageChecksum(&physics->stage));
+            PublishPhysicsSnapshot(physics, ++tick);
+        }
+
+        // Sleep until the next tick is due
+        float wait = SIMULATION_TICK - clock.accumulator;
+        if (wait > 0)
+        {
+            struct timespec duration = {0, (long)(wait * 1e6f)};
+            nanosleep(&duration, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// Start a physics thread simulating its own copy of a stage. Returns false if no thread
+// could start.
+bool StartPhysicsThread(PhysicsThread *physics, const StageData *stage, FILE *replayFile)
+{
+    *physics = (PhysicsThread){0};
+    CopyStage(&physics->stage, stage);
+    physics->stage.world.stats = &physics->stats;
+    physics->replayFile = replayFile;
+    atomic_init(&physics->running, true);
+    atomic_init(&physics->latest, 0);
+    atomic_init(&physics->reading, -1);
+    atomic_init(&physics->stageRequest, 0);
+    atomic_init(&physics->launchPending, false);
+    PublishPhysicsSnapshot(physics, 0);
+
+    if (pthread_create(&physics->thread, NULL, RunPhysicsThread, physics) != 0)
+    {
+        TraceLog(LOG_WARNING, "PHYSICS: Could not start the physics thread");
+        return false;
+    }
+
+    return true;
+}
+
+// Stop the thread and take the simulated stage back, the snapshots are released
+StageData StopPhysicsThread(PhysicsThread *physics)
+{
+    atomic_store(&physics->running, false);
+    pthread_join(physics->thread, NULL);
+
+    FreeBodyStore(&physics->snapshots[0].bodies);
+    FreeBodyStore(&physics->snapshots[1].bodies);
+
+    return physics->stage;
+}
+
+// Queue the input of a rendered frame for the next tick. A launch is dropped while the
+// previous one has not been consumed yet.
+void PostPhysicsInput(PhysicsThread *physics, FrameInput input)
+{
+    if (input.stageRequest > 0)
+    {
+        atomic_store(&physics->stageRequest, input.stageRequest);
+    }
+
+    if (input.launch && !atomic_load_explicit(&physics->launchPending, memory_order_acquire))
+    {
+        physics->launchVector = input.launchVector;
+        atomic_store_explicit(&physics->launchPending, true, memory_order_release);
+    }
+}
+
+// Mirror the latest snapshot into a render side stage: bodies are copied, and the stage
+// itself is reloaded (from the stage cache) when the physics thread changed level.
+// Never blocks the physics thread. Returns the render interpolation factor: the time
+// since the snapshot was published, in ticks, so drawing runs one tick behind.
+float ReadPhysicsSnapshot(PhysicsThread *physics, StageData *view)
+{
+    // Claim the latest snapshot, then make sure it was still the latest once claimed:
+    // from then on the physics thread publishes into the other buffer, or not at all
+    int index;
+    do
+    {
+        index = atomic_load(&physics->latest);
+        atomic_store(&physics->reading, index);
+    } while (atomic_load(&physics->latest) != index);
+
+    const PhysicsSnapshot *snapshot = &physics->snapshots[index];
+    if (snapshot->level != view->level || snapshot->victory != view->victory)
+    {
+        ReloadStage(view, snapshot->level);
+        view->victory = snapshot->victory;
+    }
+    view->launched = snapshot->launched;
+    CopyBodyStore(&view->world.bodies, &snapshot->bodies);
+    if (view->world.stats != NULL)
+    {
+        *view->world.stats = snapshot->stats;
+    }
+    double time = snapshot->time;
+
+    atomic_store(&physics->reading, -1);
+
+    return Clamp((float)(GetMonotonicTime() - time) * 1000.0f / SIMULATION_TICK, 0.0f, 1.0f);
+}
@@ -0,0 +1,202 @@
+// Everything one simulation needs, passed explicitly to every body and step function:
+// the bodies and the contact buffers the world owns, and the static walls it borrows
+// from the stage assets. Nothing is global, so any number of worlds (the live game, the
+// physics thread, trajectory previews, solver shots) can step side by side, each on its
+// own thread.
+#define MAX_PHYSICS_SUBSTEPS 64
+#define SUBSTEP_TRAVEL_FRACTION 0.5f // Fraction of the thinnest feature a body may cross per substep
+
+typedef struct PhysicsWorld
+{
+    BodyStore bodies;
+    WallContactList contacts; // Scratch of the body being stepped
+    ContactCache contactCache;
+    PhysicsStats *stats; // Step counters, NULL when not collected
+
+    // Static geometry, shared read-only between the worlds of a level
+    const StageWall *walls;
+    int wallCount;
+    float thinnestWall; // Smallest box wall width or height, bounds the physics substep length
+    WallGrid wallGrid;
+    WallBatch wallBatch; // Walls packed in grid cell order
+    DistanceField wallField;
+} PhysicsWorld;
+
+// Remove every body and contact, keeping the buffers and the walls
+void ClearPhysicsWorld(PhysicsWorld *world)
+{
+    ClearBodyStore(&world->bodies);
+    world->contacts.count = 0;
+    ClearContactCache(&world->contactCache);
+}
+
+// Make destination an independent copy of source, sharing its walls. Buffers destination
+// already owns are reused, it must be zero initialized or a world itself.
+void CopyPhysicsWorld(PhysicsWorld *destination, const PhysicsWorld *source)
+{
+    BodyStore bodies = destination->bodies;
+    WallContactList contacts = destination->contacts;
+    ContactCache contactCache = destination->contactCache;
+
+    *destination = *source;
+    destination->bodies = bodies;
+    destination->contacts = contacts;
+    destination->contacts.count = 0;
+    destination->contactCache = contactCache;
+    CopyBodyStore(&destination->bodies, &source->bodies);
+    CopyContactCache(&destination->contactCache, &source->contactCache);
+}
+
+// Release what a world owns, the walls belong to the stage assets
+void FreePhysicsWorld(PhysicsWorld *world)
+{
+    FreeBodyStore(&world->bodies);
+    FreeWallContactList(&world->contacts);
+    FreeContactCache(&world->contactCache);
+}
+
+// Slow a body down by its damping over deltaTime (ms) and stop it below the rest speed
+void ApplyBodyDamping(BodyStore *bodies, BodyHandle body, float deltaTime)
+{
+    BodyDamping damping = bodies->damping[body];
+    float speed = Vector2Length(bodies->velocity[body]);
+    if (speed == 0)
+    {
+        return;
+    }
+
+    float newSpeed = speed - damping.deceleration * deltaTime;
+    if (newSpeed <= damping.restSpeed)
+    {
+        bodies->velocity[body] = (Vector2){0, 0};
+    }
+    else
+    {
+        bodies->velocity[body] = Vector2Scale(bodies->velocity[body], newSpeed / speed);
+    }
+}
+
+// Timestamp for a stats phase, free when stats are not collected
+static double GetStatsTime(const PhysicsStats *stats)
+{
+    return (stats != NULL) ? GetMonotonicTime() : 0.0;
+}
+
+// One physics substep of deltaTime (ms) for the bodies in [first, last): every body
+// resolves the walls it already touches (warm started from the previous substep), sweeps
+// along its velocity through the wall grid, then applies its damping.
+// Bodies at rest are skipped, and bodies the distance field shows clear of every wall
+// skip the contact search (and the sweep when they cannot reach a wall this substep).
+// Bodies only read the walls and write their own state, so disjoint ranges can step on
+// different threads, each with its own contact list, cache and stats (NULL for none).
+void StepPhysicsBodies(PhysicsWorld *world, BodyHandle first, BodyHandle last, float deltaTime, WallContactList *contactList,
+                       ContactCache *contactCache, PhysicsStats *stats)
+{
+    BodyStore *bodies = &world->bodies;
+
+    for (BodyHandle body = first; body < last; body++)
+    {
+        if (bodies->velocity[body].x == 0 && bodies->velocity[body].y == 0)
+        {
+            continue;
+        }
+
+        double start = GetStatsTime(stats);
+        float clearance = GetWallClearance(&world->wallField, bodies->position[body], bodies->radius[body]);
+        int contactCount = (clearance > 0) ? 0
+                                           : FindWallContacts(&world->wallGrid, &world->wallBatch, world->walls, bodies->position[body],
+                                                              bodies->radius[body], contactList,
+                                                              (stats != NULL) ? &stats->broadphasePairs : NULL);
+        WallContact *contacts = contactList->contacts;
+        double contactEnd = GetStatsTime(stats);
+        WarmStartWallContacts(contactCache, body, contacts, contactCount);
+        int iterations = SolveWallContacts(bodies, body, contacts, contactCount);
+        StoreWallContacts(contactCache, body, contacts, contactCount);
+        double solveEnd = GetStatsTime(stats);
+        int impacts = SweepBall(&world->wallGrid, world->walls, bodies, body, deltaTime, clearance,
+                                (stats != NULL) ? &stats->droppedSweepTime : NULL);
+        double sweepEnd = GetStatsTime(stats);
+        CorrectWallContacts(bodies, body, contacts, contactCount);
+        ApplyBodyDamping(bodies, body, deltaTime);
+
+        if (stats != NULL)
+        {
+            double end = GetMonotonicTime();
+            stats->manifolds += contactCount;
+            stats->contactPoints += contactCount + impacts;
+            stats->solverIterations += iterations;
+            stats->contactTime += (float)((contactEnd - start) * 1e6);
+            stats->solveTime += (float)((solveEnd - contactEnd) * 1e6);
+            stats->sweepTime += (float)((sweepEnd - solveEnd) * 1e6);
+            stats->correctTime += (float)((end - sweepEnd) * 1e6);
+        }
+    }
+}
+
+// One physics substep of deltaTime (ms) for every body of the world
+void StepPhysicsSubstep(PhysicsWorld *world, float deltaTime)
+{
+    BeginContactCacheStep(&world->contactCache);
+    StepPhysicsBodies(world, 0, world->bodies.count, deltaTime, &world->contacts, &world->contactCache, world->stats);
+}
+
+static int ClampPhysicsSubsteps(float travel, float thinnest)
+{
+    if (travel == 0)
+    {
+        return 0;
+    }
+
+    int substeps = (int)ceilf(travel / (thinnest * SUBSTEP_TRAVEL_FRACTION));
+
+    return (substeps < 1) ? 1 : (substeps > MAX_PHYSICS_SUBSTEPS) ? MAX_PHYSICS_SUBSTEPS : substeps;
+}
+
+// Pick how many substeps a tick (ms) needs so that the fastest body never crosses more
+// than a fraction of the thinnest wall or of its own size in one substep. Bodies at rest
+// need no substeps at all.
+int GetPhysicsSubsteps(const PhysicsWorld *world, float tickTime)
+{
+    const BodyStore *bodies = &world->bodies;
+    float travel = 0.0f;
+    float thinnest = world->thinnestWall;
+
+    for (BodyHandle body = 0; body < bodies->count; body++)
+    {
+        float speed = Vector2Length(bodies->velocity[body]);
+        if (speed > 0)
+        {
+            travel = fmaxf(travel, speed * tickTime);
+            thinnest = fminf(thinnest, bodies->radius[body] * 2.0f);
+        }
+    }
+
+    return ClampPhysicsSubsteps(travel, thinnest);
+}
+
+// Substeps a tick (ms) needs for one body on its own, as if it was alone in the world
+int GetBodySubsteps(const PhysicsWorld *world, BodyHandle body, float tickTime)
+{
+    const BodyStore *bodies = &world->bodies;
+
+    return ClampPhysicsSubsteps(Vector2Length(bodies->velocity[body]) * tickTime,
+                                fminf(world->thinnestWall, bodies->radius[body] * 2.0f));
+}
+
+// Advance the physics by one tick (ms), split into the substeps the current motion needs
+void StepPhysicsWorld(PhysicsWorld *world, float tickTime)
+{
+    SaveBodyStates(&world->bodies);
+
+    int substeps = GetPhysicsSubsteps(world, tickTime);
+    if (world->stats != NULL)
+    {
+        world->stats->ticks++;
+        world->stats->steps += substeps;
+    }
+
+    for (int i = 0; i < substeps; i++)
+    {
+        StepPhysicsSubstep(world, tickTime / substeps);
+    }
+}
@@ -0,0 +1,167 @@
+// Session recording and deterministic playback.
+// A replay is a header followed by records. Every fixed simulation tick writes a TICK
+// record (a checksum of the physics state after the tick), and STAGE and LAUNCH records
+// hold the input applied before the next tick; the tick index is the timestamp, so
+// the render rate of the recording session does not matter.
+// Values are stored as little endian 32 bit words (see binary_io.h).
+#define REPLAY_MAGIC 0x5052504D // "MPRP"
+#define REPLAY_VERSION 2
+
+typedef enum ReplayRecordType
+{
+    REPLAY_TICK = 1, // uint checksum
+    REPLAY_LAUNCH,    // float x, float y
+    REPLAY_STAGE      // int level
+} ReplayRecordType;
+
+// Checksum of the simulation state, any difference in a bit of a body state changes it
+unsigned int GetStageChecksum(const StageData *stage)
+{
+    unsigned int hash = HASH_BASIS;
+    hash = HashBytes(hash, &stage->level, sizeof(stage->level));
+    hash = HashBytes(hash, &stage->launched, sizeof(stage->launched));
+    hash = HashBytes(hash, stage->world.bodies.position, stage->world.bodies.count * sizeof(Vector2));
+    hash = HashBytes(hash, stage->world.bodies.velocity, stage->world.bodies.count * sizeof(Vector2));
+    return hash;
+}
+
+FILE *OpenReplayRecording(const char *path, int level)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: Could not record to %s", path);
+        return NULL;
+    }
+
+    WriteFileWord(file, REPLAY_MAGIC);
+    WriteFileWord(file, REPLAY_VERSION);
+    WriteFileWord(file, (unsigned int)level);
+
+    return file;
+}
+
+void RecordReplayInput(FILE *file, FrameInput input)
+{
+    if (file == NULL)
+    {
+        return;
+    }
+
+    if (input.stageRequest > 0)
+    {
+        fputc(REPLAY_STAGE, file);
+        WriteFileWord(file, (unsigned int)input.stageRequest);
+    }
+    if (input.launch)
+    {
+        fputc(REPLAY_LAUNCH, file);
+        WriteFileFloat(file, input.launchVector.x);
+        WriteFileFloat(file, input.launchVector.y);
+    }
+}
+
+void RecordReplayTick(FILE *file, unsigned int checksum)
+{
+    if (file == NULL)
+    {
+        return;
+    }
+
+    fputc(REPLAY_TICK, file);
+    WriteFileWord(file, checksum);
+}
+
+void CloseReplayRecording(FILE *file)
+{
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+}
+
+// Play a recording back without a window as fast as possible, checking every tick's
+// checksum. Returns 0 when the whole session was reproduced bit for bit.
+int RunReplay(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    unsigned int magic, version, level;
+    if (file == NULL || !ReadFileWord(file, &magic) || !ReadFileWord(file, &version) ||
+        !ReadFileWord(file, &level) || magic != REPLAY_MAGIC || version != REPLAY_VERSION)
+    {
+        fprintf(stderr, "%s is not a replay\n", path);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        return 1;
+    }
+
+    StageData stage = LoadStage((int)level);
+
+    long ticks = 0;
+    int launches = 0;
+    int stageLoads = 0;
+    int status = 0;
+    double start = GetMonotonicTime();
+
+    int type;
+    while (status == 0 && (type = fgetc(file)) != EOF)
+    {
+        bool valid = true;
+        unsigned int value;
+
+        if (type == REPLAY_STAGE)
+        {
+            valid = ReadFileWord(file, &value);
+            if (valid)
+            {
+                ApplyFrameInput(&stage, (FrameInput){.stageRequest = (int)value});
+            }
+            stageLoads++;
+        }
+        else if (type == REPLAY_LAUNCH)
+        {
+            FrameInput input = {.launch = true};
+            valid = ReadFileFloat(file, &input.launchVector.x) && ReadFileFloat(file, &input.launchVector.y);
+            if (valid)
+            {
+                ApplyFrameInput(&stage, input);
+            }
+            launches++;
+        }
+        else if (type == REPLAY_TICK && ReadFileWord(file, &value))
+        {
+            UpdateStageTick(&stage);
+
+            unsigned int checksum = GetStageChecksum(&stage);
+            if (checksum != value)
+            {
+                fprintf(stderr, "Replay diverged at tick %ld: expected checksum %08x, got %08x\n", ticks, value, checksum);
+                status = 1;
+            }
+            ticks++;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Replay %s is truncated or corrupt after tick %ld\n", path, ticks);
+            status = 1;
+        }
+    }
+
+    double elapsed = GetMonotonicTime() - start;
+    printf("%ld ticks, %d launches, %d stage loads, final level %d: %s in %.3f s (%.0f ticks/s)\n", ticks, launches,
+           stageLoads, stage.level, (status == 0) ? "reproduced" : "diverged", elapsed,
+           (elapsed > 0) ? ticks / elapsed : 0.0);
+
+    FreeStage(&stage);
+    UnloadStages();
+    fclose(file);
+
+    return status;
+}
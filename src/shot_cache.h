@@ -0,0 +1,256 @@
+// Outcomes of shots already simulated, so asking again costs a lookup. A shot always
+// starts from the stage spawn, so its outcome only depends on the stage, the physics and
+// the launch velocity; entries are keyed by a key of the first two and by the exact
+// launch velocity (see GetLaunchVelocity(), drags past the maximum distance share one
+// entry), and hold exactly what the simulation gave. In memory the stage key is enough
+// (see GetShotCacheStageKey()). The cache can be saved to a file and loaded back by later
+// runs, whose entries use GetShotCacheFileKey(): outcomes simulated by other physics have
+// other keys, so they are never served (delete the file to drop them).
+#define SHOT_CACHE_MAGIC 0x4353504D // "MPSC"
+#define SHOT_CACHE_VERSION 2        // File layout
+#define SHOT_CACHE_MIN_CAPACITY 256 // Slots, always a power of two
+#define SHOT_CACHE_PROBES 8         // Full power shots simulated into each stage key
+
+typedef struct ShotOutcome
+{
+    ShotResult result; // SHOT_IN_PROGRESS when the shot ran out of time
+    Vector2 restPosition;
+    int ticks;
+    int bounces;
+} ShotOutcome;
+
+typedef struct ShotCacheEntry
+{
+    unsigned int stage; // 0 for an empty slot
+    Vector2 launch; // Launch velocity
+    ShotOutcome outcome;
+} ShotCacheEntry;
+
+// Open addressing hash table, kept at most half full
+typedef struct ShotCache
+{
+    int count;
+    int capacity;
+    ShotCacheEntry *entries;
+    int hits;
+    int misses;
+} ShotCache;
+
+// Key of the stage a shot is simulated on, never 0: the walls, spawn, goal and ball of
+// the stage and the physics constants. Enough for a cache that lives as long as the
+// process, since the physics code cannot change under it.
+unsigned int GetShotCacheStageKey(const StageData *stage)
+{
+    const BodyStore *bodies = &stage->world.bodies;
+    const StageWall *walls = stage->world.walls;
+    unsigned int hash = HashBytes(HASH_BASIS, &stage->world.wallField.wallHash, sizeof(stage->world.wallField.wallHash));
+    for (int i = 0; i < stage->world.wallCount; i++)
+    {
+        hash = HashBytes(hash, &walls[i].restitution, sizeof(walls[i].restitution));
+        hash = HashBytes(hash, &walls[i].hiddenCorners, sizeof(walls[i].hiddenCorners));
+    }
+    hash = HashBytes(hash, &stage->initialPlayerPosition, sizeof(stage->initialPlayerPosition));
+    hash = HashBytes(hash, &stage->goalPosition, sizeof(stage->goalPosition));
+    hash = HashBytes(hash, &bodies->radius[stage->ball], sizeof(float));
+    hash = HashBytes(hash, &bodies->restitution[stage->ball], sizeof(float));
+    hash = HashBytes(hash, &bodies->damping[stage->ball], sizeof(BodyDamping));
+
+    float constants[] = {SIMULATION_TICK, MAX_SHOT_TICKS, SHOT_BOUNCE_COSINE, MAX_LAUNCH_DISTANCE, MAX_LAUNCH_SPEED,
+                         GOAL_RADIUS, MAX_PHYSICS_SUBSTEPS, SUBSTEP_TRAVEL_FRACTION, MAX_SWEEP_ITERATIONS,
+                         CONTACT_SOLVER_ITERATIONS, CONTACT_SOLVER_TOLERANCE, PENETRATION_ALLOWANCE, PENETRATION_CORRECTION};
+    hash = HashBytes(hash, constants, sizeof(constants));
+
+    return (hash != 0) ? hash : 1;
+}
+
+// Key of the stage for cache files, which outlive the physics code that filled them: the
+// stage key folded with the outcomes of a few probe shots, so any change to the
+// simulation that moves a probe shot by a bit changes the key and no file has to be
+// invalidated by hand. The probes cost a few full shots on a copy of the stage, compute
+// the key once per stage.
+unsigned int GetShotCacheFileKey(const StageData *stage)
+{
+    StageData probeStage = {0};
+    CopyStage(&probeStage, stage);
+    probeStage.world.stats = NULL;
+
+    unsigned int hash = GetShotCacheStageKey(stage);
+    for (int i = 0; i < SHOT_CACHE_PROBES; i++)
+    {
+        float angle = 2.0f * PI * (i + 0.25f) / SHOT_CACHE_PROBES;
+        ShotOutcome probe = {0};
+        probe.result = SimulateShot(&probeStage, (Vector2){cosf(angle) * MAX_LAUNCH_DISTANCE, sinf(angle) * MAX_LAUNCH_DISTANCE},
+                                    &probe.ticks, &probe.bounces);
+        probe.restPosition = probeStage.restPosition;
+        hash = HashBytes(hash, &probe, sizeof(probe));
+    }
+    FreeStage(&probeStage);
+
+    return (hash != 0) ? hash : 1;
+}
+
+static int FindShotCacheSlot(const ShotCache *cache, unsigned int stageKey, Vector2 launch)
+{
+    unsigned int hash = HashBytes(stageKey, &launch, sizeof(launch));
+    int mask = cache->capacity - 1;
+    int slot = (int)(hash & (unsigned int)mask);
+
+    while (cache->entries[slot].stage != 0 &&
+           (cache->entries[slot].stage != stageKey || memcmp(&cache->entries[slot].launch, &launch, sizeof(launch)) != 0))
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void GrowShotCache(ShotCache *cache)
+{
+    ShotCache grown = *cache;
+    grown.capacity = (cache->capacity > 0) ? cache->capacity * 2 : SHOT_CACHE_MIN_CAPACITY;
+    grown.entries = (ShotCacheEntry *)calloc(grown.capacity, sizeof(ShotCacheEntry));
+
+    for (int i = 0; i < cache->capacity; i++)
+    {
+        const ShotCacheEntry *entry = &cache->entries[i];
+        if (entry->stage != 0)
+        {
+            grown.entries[FindShotCacheSlot(&grown, entry->stage, entry->launch)] = *entry;
+        }
+    }
+
+    free(cache->entries);
+    *cache = grown;
+}
+
+// Cached outcome of a shot, NULL when it was never simulated
+const ShotOutcome *FindShotOutcome(const ShotCache *cache, unsigned int stageKey, Vector2 launch)
+{
+    if (cache->capacity == 0)
+    {
+        return NULL;
+    }
+
+    const ShotCacheEntry *entry = &cache->entries[FindShotCacheSlot(cache, stageKey, launch)];
+    return (entry->stage != 0) ? &entry->outcome : NULL;
+}
+
+void StoreShotOutcome(ShotCache *cache, unsigned int stageKey, Vector2 launch, ShotOutcome outcome)
+{
+    if ((cache->count + 1) * 2 > cache->capacity)
+    {
+        GrowShotCache(cache);
+    }
+
+    ShotCacheEntry *entry = &cache->entries[FindShotCacheSlot(cache, stageKey, launch)];
+    if (entry->stage == 0)
+    {
+        cache->count++;
+    }
+    *entry = (ShotCacheEntry){stageKey, launch, outcome};
+}
+
+// Outcome of a shot on a stage with the given key, simulated (on the stage, like
+// SimulateShot()) only when the cache does not have it yet
+ShotOutcome GetShotOutcome(ShotCache *cache, StageData *stage, unsigned int stageKey, Vector2 directionVector)
+{
+    Vector2 launch = GetLaunchVelocity(directionVector);
+    const ShotOutcome *cached = FindShotOutcome(cache, stageKey, launch);
+    if (cached != NULL)
+    {
+        cache->hits++;
+        return *cached;
+    }
+
+    ShotOutcome outcome;
+    outcome.result = SimulateShot(stage, directionVector, &outcome.ticks, &outcome.bounces);
+    outcome.restPosition = stage->restPosition;
+    StoreShotOutcome(cache, stageKey, launch, outcome);
+    cache->misses++;
+
+    return outcome;
+}
+
+void FreeShotCache(ShotCache *cache)
+{
+    free(cache->entries);
+    *cache = (ShotCache){0};
+}
+
+static bool ReadShotCacheEntry(FILE *file, ShotCacheEntry *entry)
+{
+    unsigned int result, ticks, bounces;
+    bool valid = ReadFileWord(file, &entry->stage) && ReadFileFloat(file, &entry->launch.x) &&
+                 ReadFileFloat(file, &entry->launch.y) && ReadFileWord(file, &result) &&
+                 ReadFileFloat(file, &entry->outcome.restPosition.x) && ReadFileFloat(file, &entry->outcome.restPosition.y) &&
+                 ReadFileWord(file, &ticks) && ReadFileWord(file, &bounces);
+    entry->outcome.result = (ShotResult)result;
+    entry->outcome.ticks = (int)ticks;
+    entry->outcome.bounces = (int)bounces;
+    return valid;
+}
+
+static bool WriteShotCacheEntry(FILE *file, const ShotCacheEntry *entry)
+{
+    return WriteFileWord(file, entry->stage) && WriteFileFloat(file, entry->launch.x) && WriteFileFloat(file, entry->launch.y) &&
+           WriteFileWord(file, (unsigned int)entry->outcome.result) && WriteFileFloat(file, entry->outcome.restPosition.x) &&
+           WriteFileFloat(file, entry->outcome.restPosition.y) && WriteFileWord(file, (unsigned int)entry->outcome.ticks) &&
+           WriteFileWord(file, (unsigned int)entry->outcome.bounces);
+}
+
+// Add the entries of a file written by SaveShotCache() to a cache. A missing file or a
+// file of another layout adds nothing and returns false.
+bool LoadShotCache(ShotCache *cache, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    unsigned int magic, version, count;
+    bool valid = ReadFileWord(file, &magic) && ReadFileWord(file, &version) && ReadFileWord(file, &count) &&
+                 magic == SHOT_CACHE_MAGIC && version == SHOT_CACHE_VERSION;
+    if (valid)
+    {
+        ShotCacheEntry entry;
+        for (unsigned int i = 0; i < count && ReadShotCacheEntry(file, &entry); i++)
+        {
+            if (entry.stage != 0)
+            {
+                StoreShotOutcome(cache, entry.stage, entry.launch, entry.outcome);
+            }
+        }
+    }
+    fclose(file);
+
+    return valid;
+}
+
+// Write every entry of a cache (little endian words, see binary_io.h)
+bool SaveShotCache(const ShotCache *cache, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "SHOTS: Could not save the shot cache to %s", path);
+        return false;
+    }
+
+    bool written = WriteFileWord(file, SHOT_CACHE_MAGIC) && WriteFileWord(file, SHOT_CACHE_VERSION) &&
+                   WriteFileWord(file, (unsigned int)cache->count);
+    for (int i = 0; i < cache->capacity && written; i++)
+    {
+        if (cache->entries[i].stage != 0)
+        {
+            written = WriteShotCacheEntry(file, &cache->entries[i]);
+        }
+    }
+    fclose(file);
+
+    if (!written)
+    {
+        TraceLog(LOG_WARNING, "SHOTS: Could not save the shot cache to %s", path);
+        remove(path);
+    }
+    return written;
+}
@@ -0,0 +1,179 @@
+#define SIMULATION_TICK (1000.0f / 60.0f) // Fixed step of the game simulation (ms), independent of the render rate
+#define MAX_FRAME_TIME 0.25f               // Longer frames are clamped to bound the number of ticks
+#define MAX_SHOT_TICKS (60 * 60)           // Give up on a shot after one simulated minute
+#define SHOT_BOUNCE_COSINE 0.999f          // Direction changes within a tick sharper than this count as a bounce
+
+#define MAX_LAUNCH_DISTANCE 100.0f
+#define MAX_LAUNCH_SPEED 0.5f
+
+typedef enum ShotResult
+{
+    SHOT_IN_PROGRESS = 0,
+    SHOT_GOAL,
+    SHOT_MISS
+} ShotResult;
+
+// Everything the player can do in one frame, the only input the game simulation reads
+typedef struct FrameInput
+{
+    float frameTime;      // Seconds, only decides how many fixed ticks run
+    bool launch;          // Release the ball with launchVector
+    Vector2 launchVector; // Drag vector (ball - cursor)
+    int stageRequest;     // Level to load before simulating (restart or skip), 0 for none
+} FrameInput;
+
+// Rendered frame time not simulated yet, carried over to the next frame
+typedef struct SimulationClock
+{
+    float accumulator; // ms
+} SimulationClock;
+
+// Clamp a drag vector (ball - cursor) to the maximum launch distance
+Vector2 GetLaunchVector(Vector2 directionVector)
+{
+    if (Vector2Length(directionVector) > MAX_LAUNCH_DISTANCE)
+    {
+        return Vector2Scale(Vector2Normalize(directionVector), MAX_LAUNCH_DISTANCE);
+    }
+    return directionVector;
+}
+
+// Velocity given to the ball when released with a drag vector (ball - cursor)
+Vector2 GetLaunchVelocity(Vector2 directionVector)
+{
+    float launchSpeed = Remap(Vector2Length(directionVector), 0, MAX_LAUNCH_DISTANCE, 0, MAX_LAUNCH_SPEED);
+    launchSpeed = Clamp(launchSpeed, 0, MAX_LAUNCH_SPEED);
+
+    return Vector2Scale(Vector2Normalize(directionVector), launchSpeed);
+}
+
+void LaunchBall(StageData *stage, Vector2 directionVector)
+{
+    stage->world.bodies.velocity[stage->ball] = GetLaunchVelocity(directionVector);
+    stage->launched = true;
+}
+
+// Advance the physics of a stage by one fixed tick
+void StepStageTick(StageData *stage)
+{
+    StepPhysicsWorld(&stage->world, SIMULATION_TICK);
+}
+
+// Add a rendered frame (seconds) to the clock and return how many fixed ticks are due
+int AdvanceSimulationClock(SimulationClock *clock, float frameTime)
+{
+    clock->accumulator += Clamp(frameTime, 0, MAX_FRAME_TIME) * 1000.0f;
+
+    int ticks = (int)(clock->accumulator / SIMULATION_TICK);
+    clock->accumulator -= ticks * SIMULATION_TICK;
+
+    return ticks;
+}
+
+// How far the rendered frame is between the last two ticks, in [0, 1)
+float GetSimulationClockAlpha(const SimulationClock *clock)
+{
+    return clock->accumulator / SIMULATION_TICK;
+}
+
+// Once a launched ball comes to rest decide whether it reached the goal
+ShotResult UpdateShot(StageData *stage)
+{
+    Vector2 *position = &stage->world.bodies.position[stage->ball];
+    Vector2 velocity = stage->world.bodies.velocity[stage->ball];
+
+    if (!stage->launched || Vector2Length(velocity) != 0)
+    {
+        return SHOT_IN_PROGRESS;
+    }
+
+    stage->launched = false;
+    stage->restPosition = *position;
+
+    if (Vector2Distance(*position, stage->goalPosition) < GOAL_RADIUS)
+    {
+        return SHOT_GOAL;
+    }
+
+    TeleportBody(&stage->world.bodies, stage->ball, stage->initialPlayerPosition);
+    return SHOT_MISS;
+}
+
+// Launch the ball from the stage spawn and simulate fixed ticks until the shot resolves.
+// Only the ball, its contacts and the shot state of the stage are modified, so several
+// threads can simulate shots on copies of one stage (see CopyStage()). The ticks
+// simulated and the bounces of the ball are counted when ticks and bounces are not NULL.
+ShotResult SimulateShot(StageData *stage, Vector2 directionVector, int *ticks, int *bounces)
+{
+    TeleportBody(&stage->world.bodies, stage->ball, stage->initialPlayerPosition);
+    stage->world.bodies.velocity[stage->ball] = (Vector2){0, 0};
+    stage->restPosition = stage->initialPlayerPosition;
+    ClearContactCache(&stage->world.contactCache); // Impulses of the previous shot must not warm start this one
+
+    LaunchBall(stage, directionVector);
+
+    ShotResult result = SHOT_IN_PROGRESS;
+    Vector2 *velocity = &stage->world.bodies.velocity[stage->ball];
+    int tick = 0;
+    int bounceCount = 0;
+    while (result == SHOT_IN_PROGRESS && tick < MAX_SHOT_TICKS)
+    {
+        Vector2 direction = (bounces != NULL) ? Vector2Normalize(*velocity) : (Vector2){0, 0};
+
+        StepStageTick(stage);
+
+        // Rolling friction never turns the ball, only walls do
+        if (bounces != NULL && (velocity->x != 0 || velocity->y != 0) &&
+            Vector2DotProduct(direction, Vector2Normalize(*velocity)) < SHOT_BOUNCE_COSINE)
+        {
+            bounceCount++;
+        }
+        result = UpdateShot(stage);
+        tick++;
+    }
+    if (result == SHOT_IN_PROGRESS)
+    {
+        stage->restPosition = stage->world.bodies.position[stage->ball];
+    }
+
+    if (ticks != NULL)
+    {
+        *ticks = tick;
+    }
+    if (bounces != NULL)
+    {
+        *bounces = bounceCount;
+    }
+
+    return result;
+}
+
+// Apply the input of one frame: stage requests (restart or skip) first, then launches
+void ApplyFrameInput(StageData *stage, FrameInput input)
+{
+    if (input.stageRequest > 0)
+    {
+        ReloadStage(stage, input.stageRequest);
+    }
+
+    if (input.launch)
+    {
+        LaunchBall(stage, input.launchVector);
+    }
+}
+
+// Advance the game one fixed tick: the simulation itself and the move to the next level
+// once the goal is reached. Live play and replays run exactly the same ticks.
+ShotResult UpdateStageTick(StageData *stage)
+{
+    StepStageTick(stage);
+    ShotResult result = UpdateShot(stage);
+
+    if (result == SHOT_GOAL)
+    {
+        stage->goalReached = true;
+        ReloadStage(stage, stage->level + 1);
+    }
+
+    return result;
+}
@@ -0,0 +1,395 @@
+#include "raylib.h"
+#include "raymath.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+#define CUTE_TILED_IMPLEMENTATION
+#include "cute_tiled.h"
+
+#include "binary_io.h"
+#include "body_store.h"
+#include "physics_stats.h"
+#include "wall_polygon.h"
+#include "stage_collision.h"
+#include "wall_merge.h"
+#include "wall_batch.h"
+#include "distance_field.h"
+#include "timer.h"
+#include "physics_world.h"
+#include "cache_directory.h"
+#include "stage_loader.h"
+#include "simulation.h"
+#include "shot_cache.h"
+#include "event_simulation.h"
+#include "worker_pool.h"
+
+#define SOLVER_DIRECTIONS 360
+#define SOLVER_POWERS 20
+#define MAX_REPORTED_LAUNCHES 10
+// Engine cross-check tolerances (-c). Measured on the shipped levels across -O0, -O3
+// -march=native, FMA, AVX2 and WALL_BATCH_SCALAR builds: 99.58-99.90% of the outcomes
+// agree (at worst 30 of 7200 launches differ, all chaotic grazing shots) and agreed rest
+// points are at most 3.6 px apart. The limits leave about 5x the worst mismatch count and
+// 2x the worst distance, so codegen or a small physics tweak does not trip them while a
+// real divergence (a wrong bounce or friction law) still does.
+#define MIN_ENGINE_AGREEMENT 0.98f    // Fraction of launches both engines must give the same outcome
+#define MAX_ENGINE_REST_DISTANCE 8.0f // px between the rest points of a launch both engines agree on...
+#define MAX_COMPARED_IMPACTS 2        // ...when it hits at most this many walls
+#define SOLVER_USAGE "[-d directions] [-p powers] [-v] [-e] [-c] [-s cache] [level ...]"
+
+typedef struct SolverJob
+{
+    const StageData *stage;
+    int directions;
+    int powers;
+    bool events;           // Simulate with SimulateShotEvents() instead of stepping
+    const int *shots;      // Sweep index of each task, NULL when tasks are sweep indices
+    ShotResult *results;
+    Vector2 *restPositions;
+    int *eventCounts;      // Wall impacts of event driven shots, when not NULL
+    ShotOutcome *outcomes; // Whole outcomes of stepped shots, when not NULL
+} SolverJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+int SolveLevel(int level, int directions, int powers, bool verbose, bool events, ShotCache *cache);
+bool CrossCheckLevel(int level, int directions, int powers);
+bool ParseInteger(const char *text, int *value);
+
+//----------------------------------------------------------------------------------
+// Main Enry Point
+//----------------------------------------------------------------------------------
+// Usage: momentum-primal-solver [-d directions] [-p powers] [-v] [-e] [-c] [-s cache] [level ...]
+// Sweeps every launch direction and power the player can produce and reports which ones
+// end in the goal. Without levels, every resources/level%d.json file is checked.
+// -e solves with the event driven simulation instead of the stepped one, -c runs both
+// on every launch and compares them. -s keeps the outcomes of stepped shots in a cache
+// file, so launches solved by an earlier run are not simulated again.
+// Exits with 1 on unknown arguments, when a level does not exist or has no winning
+// launch, or when the engines disagree (see CrossCheckLevel()).
+int main(int argc, char **argv)
+{
+    int directions = SOLVER_DIRECTIONS;
+    int powers = SOLVER_POWERS;
+    bool verbose = false;
+    bool events = false;
+    bool crossCheck = false;
+    const char *cachePath = NULL;
+    int *levels = (int *)malloc(argc * sizeof(int));
+    int levelCount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool valid = true;
+        if (strcmp(argv[i], "-d") == 0)
+        {
+            valid = i + 1 < argc && ParseInteger(argv[++i], &directions) && directions > 0;
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            valid = i + 1 < argc && ParseInteger(argv[++i], &powers) && powers > 0;
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            events = true;
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            crossCheck = true;
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            valid = i + 1 < argc;
+            cachePath = valid ? argv[++i] : NULL;
+        }
+        else
+        {
+            valid = ParseInteger(argv[i], &levels[levelCount]);
+            levelCount += valid ? 1 : 0;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Usage: %s " SOLVER_USAGE "\n", argv[0]);
+            free(levels);
+            return 1;
+        }
+    }
+
+    if (levelCount == 0)
+    {
+        while (FileExists(TextFormat("resources/level%d.json", levelCount + 1)))
+        {
+            levelCount++;
+        }
+        levels = (int *)realloc(levels, (levelCount + 1) * sizeof(int));
+        for (int i = 0; i < levelCount; i++)
+        {
+            levels[i] = i + 1;
+        }
+    }
+
+    if (levelCount == 0)
+    {
+        fprintf(stderr, "No levels to solve\n");
+        free(levels);
+        return 1;
+    }
+
+    ShotCache cache = {0};
+    if (cachePath != NULL)
+    {
+        LoadShotCache(&cache, cachePath);
+    }
+
+    int missing = 0;
+    int unsolved = 0;
+    int mismatched = 0;
+    for (int i = 0; i < levelCount; i++)
+    {
+        // Levels without a file are errors, the game would play level 1 in their place
+        if (GetStageAssets(levels[i]) == NULL)
+        {
+            fprintf(stderr, "level %d: no resources/level%d.json\n", levels[i], levels[i]);
+            missing++;
+            continue;
+        }
+        if (SolveLevel(levels[i], directions, powers, verbose, events, (cachePath != NULL) ? &cache : NULL) == 0)
+        {
+            unsolved++;
+        }
+        if (crossCheck && !CrossCheckLevel(levels[i], directions, powers))
+        {
+            mismatched++;
+        }
+    }
+    UnloadStages();
+
+    if (cachePath != NULL)
+    {
+        SaveShotCache(&cache, cachePath);
+        FreeShotCache(&cache);
+    }
+
+    free(levels);
+
+    if (missing > 0)
+    {
+        fprintf(stderr, "%d of %d levels do not exist\n", missing, levelCount);
+    }
+    if (unsolved > 0)
+    {
+        fprintf(stderr, "%d of %d levels have no winning launch\n", unsolved, levelCount);
+    }
+    if (mismatched > 0)
+    {
+        fprintf(stderr, "%d of %d levels simulate differently with events and steps\n", mismatched, levelCount);
+    }
+
+    return (missing > 0 || unsolved > 0 || mismatched > 0) ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Whole argument as a decimal int, false on anything else
+bool ParseInteger(const char *text, int *value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || parsed < INT_MIN || parsed > INT_MAX)
+    {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+// Drag vector (ball - cursor) of a sweep index, directions major and powers minor
+Vector2 GetSweepLaunch(int index, int directions, int powers)
+{
+    float angle = 2.0f * PI * (index / powers) / directions;
+    float distance = MAX_LAUNCH_DISTANCE * (index % powers + 1) / powers;
+
+    return (Vector2){cosf(angle) * distance, sinf(angle) * distance};
+}
+
+// Each task simulates one launch. Stepping runs on a copy of the stage, which owns its
+// copy of the bodies, walls and grid are shared read-only; events only read the stage.
+static void SolveShot(int index, void *userData)
+{
+    SolverJob *job = (SolverJob *)userData;
+    int shot = (job->shots != NULL) ? job->shots[index] : index;
+    Vector2 launch = GetSweepLaunch(shot, job->directions, job->powers);
+    Vector2 *restPosition = (job->restPositions != NULL) ? &job->restPositions[shot] : NULL;
+
+    if (job->events)
+    {
+        job->results[shot] = SimulateShotEvents(job->stage, launch, restPosition, (job->eventCounts != NULL) ? &job->eventCounts[shot] : NULL);
+        return;
+    }
+
+    StageData stage = {0};
+    CopyStage(&stage, job->stage);
+    if (job->outcomes != NULL)
+    {
+        ShotOutcome *outcome = &job->outcomes[shot];
+        outcome->result = SimulateShot(&stage, launch, &outcome->ticks, &outcome->bounces);
+        outcome->restPosition = stage.restPosition;
+        job->results[shot] = outcome->result;
+    }
+    else
+    {
+        job->results[shot] = SimulateShot(&stage, launch, NULL, NULL);
+    }
+    if (restPosition != NULL)
+    {
+        *restPosition = stage.restPosition;
+    }
+    FreeStage(&stage);
+}
+
+// Sweep one level and report its winning launches. With a cache (stepped shots only),
+// launches it already holds are looked up and only the others are simulated, then added.
+int SolveLevel(int level, int directions, int powers, bool verbose, bool events, ShotCache *cache)
+{
+    StageData stage = LoadStage(level);
+    int shotCount = directions * powers;
+    SolverJob job = {&stage, directions, powers, events, NULL, (ShotResult *)malloc(shotCount * sizeof(ShotResult)), NULL, NULL, NULL};
+    int simulated = shotCount;
+
+    double start = GetMonotonicTime();
+    if (cache != NULL && !events)
+    {
+        // The cache is only read and written here, the workers never touch it
+        unsigned int stageKey = GetShotCacheFileKey(&stage);
+        int *misses = (int *)malloc(shotCount * sizeof(int));
+        simulated = 0;
+        for (int i = 0; i < shotCount; i++)
+        {
+            const ShotOutcome *cached = FindShotOutcome(cache, stageKey, GetLaunchVelocity(GetSweepLaunch(i, directions, powers)));
+            if (cached != NULL)
+            {
+                job.results[i] = cached->result;
+            }
+            else
+            {
+                misses[simulated++] = i;
+            }
+        }
+
+        job.shots = misses;
+        job.outcomes = (ShotOutcome *)malloc(shotCount * sizeof(ShotOutcome));
+        RunParallel(simulated, SolveShot, &job);
+
+        for (int i = 0; i < simulated; i++)
+        {
+            Vector2 launch = GetLaunchVelocity(GetSweepLaunch(misses[i], directions, powers));
+            StoreShotOutcome(cache, stageKey, launch, job.outcomes[misses[i]]);
+        }
+        cache->hits += shotCount - simulated;
+        cache->misses += simulated;
+
+        free(job.outcomes);
+        free(misses);
+    }
+    else
+    {
+        RunParallel(shotCount, SolveShot, &job);
+    }
+    double elapsed = GetMonotonicTime() - start;
+
+    int wins = 0;
+    for (int i = 0; i < shotCount; i++)
+    {
+        if (job.results[i] == SHOT_GOAL)
+        {
+            if (verbose || wins < MAX_REPORTED_LAUNCHES)
+            {
+                Vector2 launch = GetSweepLaunch(i, directions, powers);
+                printf("  level %d: angle %.1f deg, power %.0f%%, drag (%.2f, %.2f)\n", level,
+                       360.0f * (i / powers) / directions, 100.0f * (i % powers + 1) / powers, launch.x, launch.y);
+            }
+            wins++;
+        }
+    }
+
+    printf("level %d: %d/%d winning launches (%.1f%%) in %.2f s on %d threads%s", level, wins, shotCount,
+           100.0f * wins / shotCount, elapsed, GetWorkerCount(), events ? " (events)" : "");
+    if (simulated < shotCount)
+    {
+        printf(", %d launches from the cache", shotCount - simulated);
+    }
+    printf("\n");
+
+    free(job.results);
+    FreeStage(&stage);
+
+    return wins;
+}
+
+// Simulate every launch with both engines and compare outcomes and rest positions.
+// Returns false when they give the same outcome for too few launches, or stop a short
+// shot they agree on too far apart.
+bool CrossCheckLevel(int level, int directions, int powers)
+{
+    StageData stage = LoadStage(level);
+    int shotCount = directions * powers;
+    SolverJob jobs[2];
+    double elapsed[2];
+
+    for (int events = 0; events < 2; events++)
+    {
+        jobs[events] = (SolverJob){&stage, directions, powers, events, NULL, (ShotResult *)malloc(shotCount * sizeof(ShotResult)),
+                                   (Vector2 *)malloc(shotCount * sizeof(Vector2)), events ? (int *)malloc(shotCount * sizeof(int)) : NULL,
+                                   NULL};
+        double start = GetMonotonicTime();
+        RunParallel(shotCount, SolveShot, &jobs[events]);
+        elapsed[events] = GetMonotonicTime() - start;
+    }
+
+    // Rest points are only compared where the outcomes agree, and asserted for shots with
+    // few impacts: past a few bounces, grazing a corner a little differently sends the
+    // ball on another path, so far apart rest points there say nothing about either engine
+    int agreed = 0;
+    int compared = 0;
+    float totalDistance = 0.0f;
+    float maxDistance = 0.0f;
+    for (int i = 0; i < shotCount; i++)
+    {
+        if (jobs[0].results[i] == jobs[1].results[i])
+        {
+            agreed++;
+            if (jobs[1].eventCounts[i] <= MAX_COMPARED_IMPACTS)
+            {
+                float distance = Vector2Distance(jobs[0].restPositions[i], jobs[1].restPositions[i]);
+                compared++;
+                totalDistance += distance;
+                maxDistance = fmaxf(maxDistance, distance);
+            }
+        }
+    }
+
+    float agreement = (float)agreed / shotCount;
+    printf("level %d: events agree with steps on %d/%d outcomes (%.2f%%), rest points %.1f px apart on average "
+           "(%.1f px at most) over %d shots with %d impacts or less, %.1fx faster\n",
+           level, agreed, shotCount, 100.0f * agreement, (compared > 0) ? totalDistance / compared : 0.0f, maxDistance, compared,
+           MAX_COMPARED_IMPACTS, elapsed[0] / elapsed[1]);
+
+    for (int events = 0; events < 2; events++)
+    {
+        free(jobs[events].results);
+        free(jobs[events].restPositions);
+        free(jobs[events].eventCounts);
+    }
+    FreeStage(&stage);
+
+    return agreement >= MIN_ENGINE_AGREEMENT && maxDistance <= MAX_ENGINE_REST_DISTANCE;
+}
@@ -0,0 +1,771 @@
+#define WALL_GRID_CELL_SIZE 64.0f
+#define MAX_SWEEP_ITERATIONS 4 // Bounces resolved within a single step
+
+#define CONTACT_LIST_MIN_CAPACITY 16
+#define CONTACT_SOLVER_ITERATIONS 8
+#define CONTACT_SOLVER_TOLERANCE 1e-6f // Impulse change (px/ms) below which the solver stops
+#define PENETRATION_ALLOWANCE 0.05f
+#define PENETRATION_CORRECTION 0.4f
+
+typedef enum StageWallType
+{
+    WALL_BOX = 0, // Rectangle object
+    WALL_POLYGON, // Convex piece of a polygon object
+    WALL_EDGE     // Edge of a polyline object
+} StageWallType;
+
+// Static stage wall built from a Tiled object: a rectangle rotated around its center, a
+// convex polygon piece or a chain edge. Walls have infinite mass: they are never
+// integrated and never paired with each other, everything needed by the ball queries is
+// precomputed when the stage loads. Polygons and edges also fill the rectangle fields,
+// with their bounding box and with a zero height rectangle along the edge, for the
+// batched overlap tests.
+typedef struct StageWall
+{
+    StageWallType type;
+    const WallPolygon *polygon; // Shape of polygon and edge walls, owned by the stage assets
+    Vector2 position;    // Center of the rectangle
+    Vector2 halfExtents; // Half width and half height
+    Vector2 axis;        // Local x axis in world space (cosine, sine of the rotation)
+    float restitution;
+    Rectangle bounds; // World space axis aligned bounds
+    unsigned char hiddenCorners; // Boxes: bit per corner (GetStageWallVertex() order) that sits on another box
+} StageWall;
+
+// Uniform grid over the stage walls, cells list wall indices (compressed rows)
+typedef struct WallGrid
+{
+    Vector2 origin;
+    float cellSize;
+    int columns;
+    int rows;
+    int *cellStart; // columns * rows + 1 offsets into cellWalls
+    int *cellWalls;
+} WallGrid;
+
+typedef struct WallContact
+{
+    const StageWall *wall;
+    Vector2 normal; // From the wall towards the ball
+    float penetration;
+    float impulse; // Accumulated normal impulse per unit mass (px/ms)
+    float targetVelocity; // Normal velocity the solver aims for (px/ms)
+} WallContact;
+
+// Contacts of the body being stepped, grows to the most walls a body ever touched
+typedef struct WallContactList
+{
+    int count;
+    int capacity;
+    WallContact *contacts;
+} WallContactList;
+
+// Impulses the contacts of the previous step ended with, keyed by body and wall
+typedef struct CachedContact
+{
+    BodyHandle body;
+    const StageWall *wall;
+    float impulse;
+} CachedContact;
+
+// Contacts of the last two steps: the step being solved writes its contacts while it
+// warm starts from the ones of the previous step. Both arrays share one capacity.
+typedef struct ContactCache
+{
+    int count;
+    int previousCount;
+    int capacity;
+    CachedContact *contacts;
+    CachedContact *previous;
+} ContactCache;
+
+StageWall CreateStageWall(Rectangle rectangle, float rotation)
+{
+    StageWall wall = {0};
+    wall.halfExtents = (Vector2){rectangle.width / 2.0f, rectangle.height / 2.0f};
+    wall.position = (Vector2){rectangle.x + wall.halfExtents.x, rectangle.y + wall.halfExtents.y};
+    wall.axis = (Vector2){cosf(rotation), sinf(rotation)};
+    wall.restitution = 1.0f;
+
+    float c = fabsf(wall.axis.x);
+    float s = fabsf(wall.axis.y);
+    Vector2 extents = {wall.halfExtents.x * c + wall.halfExtents.y * s, wall.halfExtents.x * s + wall.halfExtents.y * c};
+    wall.bounds = (Rectangle){wall.position.x - extents.x, wall.position.y - extents.y, extents.x * 2.0f, extents.y * 2.0f};
+
+    return wall;
+}
+
+StageWall CreatePolygonWall(const WallPolygon *polygon)
+{
+    Vector2 min = polygon->vertices[0];
+    Vector2 max = polygon->vertices[0];
+    for (int i = 1; i < polygon->vertexCount; i++)
+    {
+        min = (Vector2){fminf(min.x, polygon->vertices[i].x), fminf(min.y, polygon->vertices[i].y)};
+        max = (Vector2){fmaxf(max.x, polygon->vertices[i].x), fmaxf(max.y, polygon->vertices[i].y)};
+    }
+
+    StageWall wall = CreateStageWall((Rectangle){min.x, min.y, max.x - min.x, max.y - min.y}, 0.0f);
+    wall.type = WALL_POLYGON;
+    wall.polygon = polygon;
+
+    return wall;
+}
+
+StageWall CreateEdgeWall(const WallPolygon *edge)
+{
+    Vector2 a = edge->vertices[0];
+    Vector2 b = edge->vertices[1];
+    float length = Vector2Distance(a, b);
+
+    StageWall wall = {0};
+    wall.type = WALL_EDGE;
+    wall.polygon = edge;
+    wall.position = Vector2Lerp(a, b, 0.5f);
+    wall.halfExtents = (Vector2){length / 2.0f, 0.0f};
+    wall.axis = Vector2Scale(Vector2Subtract(b, a), 1.0f / length);
+    wall.restitution = 1.0f;
+    wall.bounds = (Rectangle){fminf(a.x, b.x), fminf(a.y, b.y), fabsf(b.x - a.x), fabsf(b.y - a.y)};
+
+    return wall;
+}
+
+// Corners of a box, vertices of a polygon piece, ends of an edge
+int GetStageWallVertexCount(const StageWall *wall)
+{
+    return (wall->type == WALL_BOX) ? 4 : wall->polygon->vertexCount;
+}
+
+// Box corner of a point outside the box, as GetStageWallVertex() numbers them
+static int GetBoxCorner(float localX, float localY)
+{
+    return (localX > 0) ? ((localY > 0) ? 2 : 1) : ((localY > 0) ? 3 : 0);
+}
+
+// Get a wall vertex in world space (for boxes 0 to 3, clockwise from the top left)
+Vector2 GetStageWallVertex(const StageWall *wall, int index)
+{
+    if (wall->type != WALL_BOX)
+    {
+        return wall->polygon->vertices[index];
+    }
+
+    Vector2 local = {(index == 1 || index == 2) ? wall->halfExtents.x : -wall->halfExtents.x,
+                     (index >= 2) ? wall->halfExtents.y : -wall->halfExtents.y};
+    float c = wall->axis.x;
+    float s = wall->axis.y;
+
+    return (Vector2){wall->position.x + c * local.x - s * local.y, wall->position.y + s * local.x + c * local.y};
+}
+
+static int GetWallGridColumn(const WallGrid *grid, float x)
+{
+    return (int)floorf((x - grid->origin.x) / grid->cellSize);
+}
+
+static int GetWallGridRow(const WallGrid *grid, float y)
+{
+    return (int)floorf((y - grid->origin.y) / grid->cellSize);
+}
+
+static int ClampGridIndex(int index, int count)
+{
+    return (index < 0) ? 0 : (index >= count) ? count - 1 : index;
+}
+
+WallGrid BuildWallGrid(const StageWall *walls, int wallCount, float cellSize)
+{
+    WallGrid grid = {0};
+    grid.cellSize = cellSize;
+
+    if (wallCount == 0)
+    {
+        return grid;
+    }
+
+    Vector2 min = {walls[0].bounds.x, walls[0].bounds.y};
+    Vector2 max = {walls[0].bounds.x + walls[0].bounds.width, walls[0].bounds.y + walls[0].bounds.height};
+    for (int i = 1; i < wallCount; i++)
+    {
+        min.x = fminf(min.x, walls[i].bounds.x);
+        min.y = fminf(min.y, walls[i].bounds.y);
+        max.x = fmaxf(max.x, walls[i].bounds.x + walls[i].bounds.width);
+        max.y = fmaxf(max.y, walls[i].bounds.y + walls[i].bounds.height);
+    }
+
+    grid.origin = min;
+    grid.columns = (int)floorf((max.x - min.x) / cellSize) + 1;
+    grid.rows = (int)floorf((max.y - min.y) / cellSize) + 1;
+
+    int cellCount = grid.columns * grid.rows;
+    grid.cellStart = (int *)calloc(cellCount + 1, sizeof(int));
+
+    // Count walls per cell, then turn the counts into offsets and fill
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < wallCount; i++)
+        {
+            Rectangle bounds = walls[i].bounds;
+            int x0 = ClampGridIndex(GetWallGridColumn(&grid, bounds.x), grid.columns);
+            int x1 = ClampGridIndex(GetWallGridColumn(&grid, bounds.x + bounds.width), grid.columns);
+            int y0 = ClampGridIndex(GetWallGridRow(&grid, bounds.y), grid.rows);
+            int y1 = ClampGridIndex(GetWallGridRow(&grid, bounds.y + bounds.height), grid.rows);
+
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    int cell = y * grid.columns + x;
+                    if (pass == 0)
+                    {
+                        grid.cellStart[cell + 1]++;
+                    }
+                    else
+                    {
+                        grid.cellWalls[grid.cellStart[cell]++] = i;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (int cell = 0; cell < cellCount; cell++)
+            {
+                grid.cellStart[cell + 1] += grid.cellStart[cell];
+            }
+            grid.cellWalls = (int *)malloc(grid.cellStart[cellCount] * sizeof(int));
+        }
+    }
+
+    // The fill pass advanced each start to the next cell's start, shift them back
+    for (int cell = cellCount; cell > 0; cell--)
+    {
+        grid.cellStart[cell] = grid.cellStart[cell - 1];
+    }
+    grid.cellStart[0] = 0;
+
+    return grid;
+}
+
+void FreeWallGrid(WallGrid *grid)
+{
+    free(grid->cellStart);
+    free(grid->cellWalls);
+    *grid = (WallGrid){0};
+}
+
+// Get the range of grid cells overlapped by an area, false when it misses the grid
+bool GetWallGridRange(const WallGrid *grid, Rectangle area, int *x0, int *x1, int *y0, int *y1)
+{
+    if (grid->cellStart == NULL)
+    {
+        return false;
+    }
+
+    *x0 = GetWallGridColumn(grid, area.x);
+    *x1 = GetWallGridColumn(grid, area.x + area.width);
+    *y0 = GetWallGridRow(grid, area.y);
+    *y1 = GetWallGridRow(grid, area.y + area.height);
+
+    if (*x1 < 0 || *y1 < 0 || *x0 >= grid->columns || *y0 >= grid->rows)
+    {
+        return false;
+    }
+
+    *x0 = ClampGridIndex(*x0, grid->columns);
+    *x1 = ClampGridIndex(*x1, grid->columns);
+    *y0 = ClampGridIndex(*y0, grid->rows);
+    *y1 = ClampGridIndex(*y1, grid->rows);
+
+    return true;
+}
+
+// A wall spanning several cells of a query range is only taken from the first of them,
+// which keeps grid queries free of any shared scratch state
+bool IsFirstWallGridCell(const WallGrid *grid, Rectangle bounds, int x, int y, int x0, int y0)
+{
+    int firstX = ClampGridIndex(GetWallGridColumn(grid, bounds.x), grid->columns);
+    int firstY = ClampGridIndex(GetWallGridRow(grid, bounds.y), grid->rows);
+
+    return (x == ((firstX > x0) ? firstX : x0)) && (y == ((firstY > y0) ? firstY : y0));
+}
+
+// Circle against rotated rectangle
+static bool GetBoxContact(const StageWall *wall, Vector2 center, float radius, Vector2 *worldNormal, float *worldPenetration)
+{
+    float c = wall->axis.x;
+    float s = wall->axis.y;
+    Vector2 delta = Vector2Subtract(center, wall->position);
+    Vector2 local = {c * delta.x + s * delta.y, -s * delta.x + c * delta.y};
+    Vector2 closest = {Clamp(local.x, -wall->halfExtents.x, wall->halfExtents.x),
+                       Clamp(local.y, -wall->halfExtents.y, wall->halfExtents.y)};
+    Vector2 normal;
+    float penetration;
+
+    if (closest.x == local.x && closest.y == local.y)
+    {
+        // Center inside the rectangle, push out through the nearest face
+        float distanceX = wall->halfExtents.x - fabsf(local.x);
+        float distanceY = wall->halfExtents.y - fabsf(local.y);
+        if (distanceX < distanceY)
+        {
+            normal = (Vector2){(local.x < 0) ? -1.0f : 1.0f, 0};
+            penetration = radius + distanceX;
+        }
+        else
+        {
+            normal = (Vector2){0, (local.y < 0) ? -1.0f : 1.0f};
+            penetration = radius + distanceY;
+        }
+    }
+    else
+    {
+        if (closest.x != local.x && closest.y != local.y && (wall->hiddenCorners & (1 << GetBoxCorner(local.x, local.y))))
+        {
+            return false; // Corner on a seam, the neighbouring box faces handle it
+        }
+
+        Vector2 offset = Vector2Subtract(local, closest);
+        float distance = Vector2Length(offset);
+        if (distance >= radius)
+        {
+            return false;
+        }
+        normal = Vector2Scale(offset, 1.0f / distance);
+        penetration = radius - distance;
+    }
+
+    *worldNormal = (Vector2){c * normal.x - s * normal.y, s * normal.x + c * normal.y};
+    *worldPenetration = penetration;
+
+    return true;
+}
+
+// Circle against any wall, fills the contact when they overlap
+bool GetWallContact(const StageWall *wall, Vector2 center, float radius, WallContact *contact)
+{
+    Vector2 normal;
+    float penetration;
+    bool touching = (wall->type == WALL_POLYGON) ? GetPolygonContact(wall->polygon, center, radius, &normal, &penetration)
+                    : (wall->type == WALL_EDGE)  ? GetEdgeContact(wall->polygon, center, radius, &normal, &penetration)
+                                                 : GetBoxContact(wall, center, radius, &normal, &penetration);
+    if (!touching)
+    {
+        return false;
+    }
+
+    contact->wall = wall;
+    contact->normal = normal;
+    contact->penetration = penetration;
+    contact->impulse = 0.0f;
+
+    return true;
+}
+
+// Make room for at least capacity contacts in a list, the listed contacts are kept
+void ReserveWallContacts(WallContactList *list, int capacity)
+{
+    if (capacity <= list->capacity)
+    {
+        return;
+    }
+
+    int newCapacity = (list->capacity > 0) ? list->capacity * 2 : CONTACT_LIST_MIN_CAPACITY;
+    list->capacity = (newCapacity > capacity) ? newCapacity : capacity;
+    list->contacts = (WallContact *)realloc(list->contacts, list->capacity * sizeof(WallContact));
+}
+
+void FreeWallContactList(WallContactList *list)
+{
+    free(list->contacts);
+    *list = (WallContactList){0};
+}
+
+// Make room for at least capacity contacts per step, the stored contacts are kept
+static void ReserveCachedContacts(ContactCache *cache, int capacity)
+{
+    if (capacity <= cache->capacity)
+    {
+        return;
+    }
+
+    int newCapacity = (cache->capacity > 0) ? cache->capacity * 2 : CONTACT_LIST_MIN_CAPACITY;
+    cache->capacity = (newCapacity > capacity) ? newCapacity : capacity;
+    cache->contacts = (CachedContact *)realloc(cache->contacts, cache->capacity * sizeof(CachedContact));
+    cache->previous = (CachedContact *)realloc(cache->previous, cache->capacity * sizeof(CachedContact));
+}
+
+// Forget every contact, keeping the arrays
+void ClearContactCache(ContactCache *cache)
+{
+    cache->count = 0;
+    cache->previousCount = 0;
+}
+
+// Start a new step, the contacts stored so far become the previous step
+void BeginContactCacheStep(ContactCache *cache)
+{
+    CachedContact *previous = cache->previous;
+    cache->previous = cache->contacts;
+    cache->contacts = previous;
+    cache->previousCount = cache->count;
+    cache->count = 0;
+}
+
+// Make destination hold the same contacts as source, reusing the destination arrays
+void CopyContactCache(ContactCache *destination, const ContactCache *source)
+{
+    destination->count = source->count;
+    destination->previousCount = source->previousCount;
+    if (source->capacity == 0)
+    {
+        return;
+    }
+
+    ReserveCachedContacts(destination, source->capacity);
+    memcpy(destination->contacts, source->contacts, source->count * sizeof(CachedContact));
+    memcpy(destination->previous, source->previous, source->previousCount * sizeof(CachedContact));
+}
+
+void FreeContactCache(ContactCache *cache)
+{
+    free(cache->contacts);
+    free(cache->previous);
+    *cache = (ContactCache){0};
+}
+
+// Give every contact of a body that already existed in the previous step its last impulse.
+// The previous step stored its contacts in body order, so the body's own contacts are
+// found by a binary search and only those few are compared.
+void WarmStartWallContacts(const ContactCache *cache, BodyHandle body, WallContact *contacts, int contactCount)
+{
+    if (contactCount == 0)
+    {
+        return;
+    }
+
+    int low = 0;
+    int high = cache->previousCount;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (cache->previous[middle].body < body)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        for (int j = low; j < cache->previousCount && cache->previous[j].body == body; j++)
+        {
+            if (cache->previous[j].wall == contacts[i].wall)
+            {
+                contacts[i].impulse = cache->previous[j].impulse;
+                break;
+            }
+        }
+    }
+}
+
+// Keep the solved impulses of a body for the next step. Within a step bodies must be
+// stored in increasing handle order, as StepPhysicsBodies() steps them.
+void StoreWallContacts(ContactCache *cache, BodyHandle body, const WallContact *contacts, int contactCount)
+{
+    ReserveCachedContacts(cache, cache->count + contactCount);
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        if (contacts[i].impulse > 0)
+        {
+            cache->contacts[cache->count++] = (CachedContact){body, contacts[i].wall, contacts[i].impulse};
+        }
+    }
+}
+
+// Sequential impulses against static walls. Walls never move, so an impulse per unit
+// mass only changes the body velocity. Each contact accumulates its impulse, clamped so
+// it only ever pushes; the bounce target comes from the approach velocity before any
+// impulse. Contacts carried over from the previous step start from the impulse they
+// ended with (warm starting), so a ball resting or sliding against a wall is usually
+// solved by the first pass. Returns the number of passes run.
+int SolveWallContacts(BodyStore *bodies, BodyHandle body, WallContact *contacts, int contactCount)
+{
+    if (!bodies->enabled[body] || contactCount == 0)
+    {
+        return 0;
+    }
+
+    Vector2 velocity = bodies->velocity[body];
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        float contactVelocity = Vector2DotProduct(velocity, contacts[i].normal);
+        float restitution = sqrtf(bodies->restitution[body] * contacts[i].wall->restitution);
+        contacts[i].targetVelocity = (contactVelocity < 0) ? -restitution * contactVelocity : 0.0f;
+    }
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        velocity = Vector2Add(velocity, Vector2Scale(contacts[i].normal, contacts[i].impulse));
+    }
+
+    int iteration = 0;
+    while (iteration < CONTACT_SOLVER_ITERATIONS)
+    {
+        float largestChange = 0.0f;
+
+        for (int i = 0; i < contactCount; i++)
+        {
+            WallContact *contact = &contacts[i];
+            float contactVelocity = Vector2DotProduct(velocity, contact->normal);
+            float impulse = fmaxf(contact->impulse + contact->targetVelocity - contactVelocity, 0.0f);
+            float change = impulse - contact->impulse;
+
+            contact->impulse = impulse;
+            velocity = Vector2Add(velocity, Vector2Scale(contact->normal, change));
+            largestChange = fmaxf(largestChange, fabsf(change));
+        }
+
+        // A single contact is solved exactly by one pass
+        iteration++;
+        if (largestChange <= CONTACT_SOLVER_TOLERANCE || contactCount == 1)
+        {
+            break;
+        }
+    }
+
+    bodies->velocity[body] = velocity;
+
+    return iteration;
+}
+
+// Push a body out of the walls it was penetrating before the step integrated it
+void CorrectWallContacts(BodyStore *bodies, BodyHandle body, const WallContact *contacts, int contactCount)
+{
+    if (!bodies->enabled[body])
+    {
+        return;
+    }
+
+    for (int i = 0; i < contactCount; i++)
+    {
+        const WallContact *contact = &contacts[i];
+        float correction = fmaxf(contact->penetration - PENETRATION_ALLOWANCE, 0.0f) * PENETRATION_CORRECTION;
+        bodies->position[body] = Vector2Add(bodies->position[body], Vector2Scale(contact->normal, correction));
+    }
+}
+
+// Time of impact of a circle moving by displacement against a wall, as a fraction of
+// the displacement. The circle is swept as a ray against the wall rectangle grown by
+// the radius, with rounded corners. Circles already touching the wall report no
+// impact: overlaps are resolved by the discrete contacts.
+bool SweepWall(const StageWall *wall, Vector2 center, float radius, Vector2 displacement, float *timeOfImpact, Vector2 *normal)
+{
+    if (wall->type == WALL_POLYGON)
+    {
+        return SweepPolygon(wall->polygon, center, radius, displacement, timeOfImpact, normal);
+    }
+    if (wall->type == WALL_EDGE)
+    {
+        return SweepEdge(wall->polygon, center, radius, displacement, timeOfImpact, normal);
+    }
+
+    float c = wall->axis.x;
+    float s = wall->axis.y;
+    Vector2 delta = Vector2Subtract(center, wall->position);
+    float start[2] = {c * delta.x + s * delta.y, -s * delta.x + c * delta.y};
+    float direction[2] = {c * displacement.x + s * displacement.y, -s * displacement.x + c * displacement.y};
+    float halfExtents[2] = {wall->halfExtents.x, wall->halfExtents.y};
+
+    // Slab test against the rectangle grown by the radius
+    float enter = -INFINITY;
+    float exit = INFINITY;
+    int enterAxis = 0;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        float extent = halfExtents[axis] + radius;
+        if (direction[axis] == 0)
+        {
+            if (fabsf(start[axis]) > extent)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float t0 = (-extent - start[axis]) / direction[axis];
+        float t1 = (extent - start[axis]) / direction[axis];
+        if (t0 > t1)
+        {
+            float t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+        if (t0 > enter)
+        {
+            enter = t0;
+            enterAxis = axis;
+        }
+        exit = fminf(exit, t1);
+    }
+
+    if (enter > exit || exit < 0 || enter > 1.0f)
+    {
+        return false;
+    }
+
+    float hit[2] = {start[0] + direction[0] * fmaxf(enter, 0), start[1] + direction[1] * fmaxf(enter, 0)};
+    Vector2 localNormal;
+
+    if (fabsf(hit[0]) <= halfExtents[0] || fabsf(hit[1]) <= halfExtents[1])
+    {
+        // Face region, a ray starting here is already inside the rounded rectangle
+        if (enter < 0)
+        {
+            return false;
+        }
+        *timeOfImpact = enter;
+        localNormal = (enterAxis == 0) ? (Vector2){(direction[0] < 0) ? 1.0f : -1.0f, 0}
+                                       : (Vector2){0, (direction[1] < 0) ? 1.0f : -1.0f};
+    }
+    else
+    {
+        // Corner region, the ray has to hit the circle around the corner
+        if (wall->hiddenCorners & (1 << GetBoxCorner(hit[0], hit[1])))
+        {
+            return false;
+        }
+        Vector2 corner = {(hit[0] < 0) ? -halfExtents[0] : halfExtents[0], (hit[1] < 0) ? -halfExtents[1] : halfExtents[1]};
+        Vector2 offset = {start[0] - corner.x, start[1] - corner.y};
+        Vector2 ray = {direction[0], direction[1]};
+        float a = Vector2DotProduct(ray, ray);
+        float b = Vector2DotProduct(offset, ray);
+        float k = Vector2DotProduct(offset, offset) - radius * radius;
+        float discriminant = b * b - a * k;
+
+        if (k <= 0 || b >= 0 || discriminant < 0)
+        {
+            return false;
+        }
+
+        float t = (-b - sqrtf(discriminant)) / a;
+        if (t > 1.0f)
+        {
+            return false;
+        }
+        *timeOfImpact = t;
+        localNormal = Vector2Scale(Vector2Add(offset, Vector2Scale(ray, t)), 1.0f / radius);
+    }
+
+    *normal = (Vector2){c * localNormal.x - s * localNormal.y, s * localNormal.x + c * localNormal.y};
+
+    return true;
+}
+
+// Earliest impact of a moving circle against the walls its swept bounds overlap. The
+// grid cells are walked in place, however many walls they hold.
+bool SweepWalls(const WallGrid *grid, const StageWall *walls, Vector2 center, float radius, Vector2 displacement,
+                float *timeOfImpact, Vector2 *normal, const StageWall **hitWall)
+{
+    Vector2 end = Vector2Add(center, displacement);
+    Rectangle area = {fminf(center.x, end.x) - radius, fminf(center.y, end.y) - radius,
+                      fabsf(displacement.x) + radius * 2.0f, fabsf(displacement.y) + radius * 2.0f};
+    int x0, x1, y0, y1;
+    bool hit = false;
+    *timeOfImpact = 1.0f;
+
+    if (!GetWallGridRange(grid, area, &x0, &x1, &y0, &y1))
+    {
+        return false;
+    }
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            int cell = y * grid->columns + x;
+            for (int i = grid->cellStart[cell]; i < grid->cellStart[cell + 1]; i++)
+            {
+                const StageWall *wall = &walls[grid->cellWalls[i]];
+                float t;
+                Vector2 wallNormal;
+
+                if (IsFirstWallGridCell(grid, wall->bounds, x, y, x0, y0) &&
+                    SweepWall(wall, center, radius, displacement, &t, &wallNormal) && t <= *timeOfImpact)
+                {
+                    *timeOfImpact = t;
+                    *normal = wallNormal;
+                    *hitWall = wall;
+                    hit = true;
+                }
+            }
+        }
+    }
+
+    return hit;
+}
+
+// Move a body by its velocity over deltaTime (ms), stopping at each wall impact to
+// bounce and continuing with the remaining time, so fast balls never tunnel. Bodies
+// that travel less than clearance (how far they are known to be from every wall, zero or
+// less when unknown) move without sweeping. Returns the number of impacts.
+// Time left after MAX_SWEEP_ITERATIONS impacts is dropped, and added to droppedTime (ms)
+// when it is not NULL. Only a ball wedged between walls hits that many in one substep,
+// and substeps are short enough that it crosses a fraction of its radius or of the
+// thinnest wall in one: the dropped motion is shorter than that, would only have been
+// more bounces in place, and the velocity after the last bounce is kept, so the ball
+// loses no speed and goes on from the same point in the next substep.
+int SweepBall(const WallGrid *grid, const StageWall *walls, BodyStore *bodies, BodyHandle body, float deltaTime, float clearance,
+              float *droppedTime)
+{
+    if (!bodies->enabled[body])
+    {
+        return 0;
+    }
+
+    if (Vector2Length(bodies->velocity[body]) * deltaTime < clearance)
+    {
+        bodies->position[body] = Vector2Add(bodies->position[body], Vector2Scale(bodies->velocity[body], deltaTime));
+        return 0;
+    }
+
+    float remaining = deltaTime;
+    int impacts = 0;
+    for (int iteration = 0; iteration < MAX_SWEEP_ITERATIONS && remaining > 0; iteration++)
+    {
+        Vector2 displacement = Vector2Scale(bodies->velocity[body], remaining);
+        float timeOfImpact;
+        Vector2 normal;
+        const StageWall *wall;
+
+        if (!SweepWalls(grid, walls, bodies->position[body], bodies->radius[body], displacement, &timeOfImpact, &normal, &wall))
+        {
+            bodies->position[body] = Vector2Add(bodies->position[body], displacement);
+            return impacts;
+        }
+
+        bodies->position[body] = Vector2Add(bodies->position[body], Vector2Scale(displacement, timeOfImpact));
+        remaining -= remaining * timeOfImpact;
+        impacts++;
+
+        float contactVelocity = Vector2DotProduct(bodies->velocity[body], normal);
+        if (contactVelocity < 0)
+        {
+            float restitution = sqrtf(bodies->restitution[body] * wall->restitution);
+            bodies->velocity[body] = Vector2Add(bodies->velocity[body], Vector2Scale(normal, -(1.0f + restitution) * contactVelocity));
+        }
+    }
+
+    if (droppedTime != NULL && remaining > 0)
+    {
+        *droppedTime += remaining;
+    }
+
+    return impacts;
+}
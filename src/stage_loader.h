@@ -1,3 +1,8 @@
+#define GOAL_RADIUS 50.0f
+#define PLAYER_RADIUS 15.0f
+#define BALL_DECELERATION 0.00006f // Rolling friction, px/ms of speed lost per ms
+#define BALL_REST_SPEED 0.005f     // px/ms, slower balls stop
+
 typedef struct StageData
 {
     int level;
@@ -8,76 +13,302 @@ typedef struct StageData
     bool goalReached;
     double goalReachedAt;
     bool launched;
+    Vector2 restPosition; // Where the last launched ball came to rest
 
-    PhysicsBody ball;
+    PhysicsWorld world;
+    BodyHandle ball;
 
     bool victory;
 
 } StageData;
 
-StageData LoadStage(int level)
+// The physics world belongs to each StageData (see CopyStage()), everything else points
+// into the shared assets of the level.
+
+// Parsed map and static colliders of a level. Walls never move, so every StageData of a
+// level shares one copy, built the first time the level loads and kept until
+// UnloadStages(): restarting or revisiting a level parses nothing and allocates nothing.
+// Building is the only write to the cache, so once PreloadStages() ran, stages can be
+// loaded from any thread.
+typedef struct StageAssets
 {
-    StageData stage = {0};
+    int level;
+    cute_tiled_map_t *map;
+    Vector2 initialPlayerPosition;
+    Vector2 goalPosition;
+    int bodyCount; // Bodies a stage of the level starts with
+    WallPolygon *polygons; // Convex pieces and chain edges the polygon and edge walls point to
+    int polygonCount;
+    StageWall *walls;
+    int wallCount;
+    float thinnestWall;
+    WallGrid wallGrid;
+    WallBatch wallBatch;
+    DistanceField wallField;
+} StageAssets;
+
+static StageAssets *stageCache = NULL;
+static int stageCacheCount = 0;
+static int stageCacheCapacity = 0;
 
-    if (level >= 4)
+// Vertices of a polygon or polyline object in world space. Tiled stores them relative
+// to the object position and rotates them around it.
+static void GetObjectVertices(const cute_tiled_object_t *object, Vector2 *vertices)
+{
+    float c = cosf(object->rotation * DEG2RAD);
+    float s = sinf(object->rotation * DEG2RAD);
+    for (int i = 0; i < object->vert_count; i++)
     {
-        stage.victory = true;
-        level = 1;
+        float x = object->vertices[i * 2];
+        float y = object->vertices[i * 2 + 1];
+        vertices[i] = (Vector2){object->x + c * x - s * y, object->y + s * x + c * y};
     }
+}
 
-    stage.level = level;
+// Walls an object becomes: one for a rectangle, at most n - 2 convex pieces for a polygon
+// of n vertices and n - 1 edges for a polyline. Degenerate polygons and polylines (too
+// few vertices) give none and are skipped.
+static int GetObjectShapeCount(const cute_tiled_object_t *object)
+{
+    int shapes = (object->vertices == NULL) ? 1 : (object->vert_type == 1) ? object->vert_count - 2 : object->vert_count - 1;
+    return (shapes > 0) ? shapes : 0;
+}
 
-    char *stagePath = (char *)malloc(21 * sizeof(char));
-    sprintf(stagePath, "resources/level%d.json", level);
-    stage.map = cute_tiled_load_map_from_file(stagePath, NULL);
-    free(stagePath);
+// Build the colliders of a parsed map, the assets take ownership of the map. Rectangles
+// become box walls, polygons are cut into convex pieces and polylines into edge chains.
+// Every array is sized from the objects of the map up front, so stages of any size load
+// without reallocating, and the assets cache keeps the result for every later load.
+// The distance field is read from fieldPath when it was baked from the same walls, and
+// baked and written there otherwise (always baked when fieldPath is NULL). A field that
+// cannot be written is only baked again next time.
+StageAssets BuildStageAssets(int level, cute_tiled_map_t *map, const char *fieldPath)
+{
+    StageAssets assets = {0};
+
+    assets.level = level;
+    assets.map = map;
+
+    int wallCapacity = 0;
+    int polygonCapacity = 0;
+    int vertexCapacity = 0;
     cute_tiled_layer_t *layer;
-    for (layer = stage.map->layers; layer != NULL; layer = layer->next)
+    for (layer = assets.map->layers; layer != NULL; layer = layer->next)
+    {
+        cute_tiled_object_t *object;
+        for (object = layer->objects; object != NULL; object = object->next)
+        {
+            int shapes = GetObjectShapeCount(object);
+            if (object->vertices != NULL && shapes > 0)
+            {
+                polygonCapacity += shapes;
+                vertexCapacity = (object->vert_count > vertexCapacity) ? object->vert_count : vertexCapacity;
+            }
+            wallCapacity += shapes;
+        }
+    }
+    assets.walls = (StageWall *)malloc(wallCapacity * sizeof(StageWall));
+    assets.polygons = (WallPolygon *)malloc(polygonCapacity * sizeof(WallPolygon));
+    Vector2 *vertices = (vertexCapacity > 0) ? (Vector2 *)malloc(vertexCapacity * sizeof(Vector2)) : NULL;
+    assets.thinnestWall = INFINITY;
+
+    for (layer = assets.map->layers; layer != NULL; layer = layer->next)
     {
         cute_tiled_object_t *object;
         for (object = layer->objects; object != NULL; object = object->next)
         {
             if (object->property_count > 0)
             {
-                stage.initialPlayerPosition.x = object->x;
-                stage.initialPlayerPosition.y = object->y;
+                assets.initialPlayerPosition.x = object->x;
+                assets.initialPlayerPosition.y = object->y;
+                assets.bodyCount = 1;
             }
             else if (object->ellipse)
             {
-                stage.goalPosition = (Vector2){object->x + GOAL_RADIUS / 2, object->y + GOAL_RADIUS / 2};
+                assets.goalPosition = (Vector2){object->x + GOAL_RADIUS / 2, object->y + GOAL_RADIUS / 2};
             }
-            else
+            else if (object->vertices != NULL && GetObjectShapeCount(object) > 0)
             {
-                PhysicsBody body = CreatePhysicsBodyRectangle((Vector2){0, 0}, object->width, object->height, 10.0f);
-
-                if (object->rotation != 0)
+                // Pieces of one polygon together are as thick as the polygon, and the
+                // sweeps keep balls out of edges, so neither bounds the substeps
+                GetObjectVertices(object, vertices);
+                WallPolygon *shapes = &assets.polygons[assets.polygonCount];
+                int shapeCount = (object->vert_type == 1) ? DecomposePolygon(vertices, object->vert_count, shapes)
+                                                          : BuildEdgeChain(vertices, object->vert_count, shapes);
+                for (int i = 0; i < shapeCount; i++)
                 {
-                    // body->position.x -= object->width / 2.0f;
+                    assets.walls[assets.wallCount++] = (object->vert_type == 1) ? CreatePolygonWall(&shapes[i]) : CreateEdgeWall(&shapes[i]);
                 }
+                assets.polygonCount += shapeCount;
+            }
+            else if (object->vertices == NULL && object->width > 0 && object->height > 0)
+            {
+                Rectangle rectangle = {object->x, object->y, object->width, object->height};
+                assets.walls[assets.wallCount++] = CreateStageWall(rectangle, object->rotation * DEG2RAD);
+            }
+        }
+    }
+    free(vertices);
 
-                SetPhysicsBodyRotation(body, object->rotation * DEG2RAD);
+    assets.wallCount = MergeBoxWalls(assets.walls, assets.wallCount);
+    for (int i = 0; i < assets.wallCount; i++)
+    {
+        if (assets.walls[i].type == WALL_BOX)
+        {
+            assets.thinnestWall = fminf(assets.thinnestWall, fminf(assets.walls[i].halfExtents.x, assets.walls[i].halfExtents.y) * 2.0f);
+        }
+    }
 
-                body->position.x += object->x + object->width / 2.0f;
-                body->position.y += object->y + object->height / 2.0f;
-                body->enabled = false;
-                body->restitution = 1.0f;
-            }
+    assets.wallGrid = BuildWallGrid(assets.walls, assets.wallCount, WALL_GRID_CELL_SIZE);
+    HideWallSeamCorners(assets.walls, assets.wallCount, &assets.wallGrid);
+    assets.wallBatch = BuildWallBatch(assets.walls, assets.wallGrid.cellWalls,
+                                      (assets.wallGrid.cellStart != NULL) ? assets.wallGrid.cellStart[assets.wallGrid.columns * assets.wallGrid.rows] : 0);
+
+    if (fieldPath == NULL || !LoadDistanceField(fieldPath, GetWallGeometryHash(assets.walls, assets.wallCount), &assets.wallField))
+    {
+        assets.wallField = BakeDistanceField(assets.walls, assets.wallCount);
+        if (fieldPath != NULL)
+        {
+            SaveDistanceField(fieldPath, &assets.wallField);
         }
     }
 
+    return assets;
+}
+
+void FreeStageAssets(StageAssets *assets)
+{
+    FreeDistanceField(&assets->wallField);
+    FreeWallBatch(&assets->wallBatch);
+    FreeWallGrid(&assets->wallGrid);
+    free(assets->walls);
+    free(assets->polygons);
+    cute_tiled_free_map(assets->map);
+    *assets = (StageAssets){0};
+}
+
+// Assets of a level, built on first use. NULL when there is no such level file.
+const StageAssets *GetStageAssets(int level)
+{
+    for (int i = 0; i < stageCacheCount; i++)
+    {
+        if (stageCache[i].level == level)
+        {
+            return &stageCache[i];
+        }
+    }
+
+    char stagePath[64];
+    sprintf(stagePath, "resources/level%d.json", level);
+    if (!FileExists(stagePath))
+    {
+        return NULL;
+    }
+
+    if (stageCacheCount == stageCacheCapacity)
+    {
+        stageCacheCapacity = (stageCacheCapacity > 0) ? stageCacheCapacity * 2 : 8;
+        stageCache = (StageAssets *)realloc(stageCache, stageCacheCapacity * sizeof(StageAssets));
+    }
+    char fieldPath[600];
+    bool cached = GetCacheFilePath(TextFormat("level%d.field", level), fieldPath, sizeof(fieldPath));
+    stageCache[stageCacheCount] = BuildStageAssets(level, cute_tiled_load_map_from_file(stagePath, NULL), cached ? fieldPath : NULL);
+
+    return &stageCache[stageCacheCount++];
+}
+
+// Build the assets of every level up front, so no level transition parses a map
+void PreloadStages(void)
+{
+    int level = 1;
+    while (GetStageAssets(level) != NULL)
+    {
+        level++;
+    }
+}
+
+// Put a stage at the start of a level. The bodies and contact buffers the stage already
+// has are reused, and reserved for the level up front, so only a stage bigger than any
+// previous one allocates.
+void SetupStage(StageData *stage, const StageAssets *assets)
+{
+    stage->level = assets->level;
+    stage->map = assets->map;
+    stage->initialPlayerPosition = assets->initialPlayerPosition;
+    stage->goalPosition = assets->goalPosition;
+    stage->world.walls = assets->walls;
+    stage->world.wallCount = assets->wallCount;
+    stage->world.thinnestWall = assets->thinnestWall;
+    stage->world.wallGrid = assets->wallGrid;
+    stage->world.wallBatch = assets->wallBatch;
+    stage->world.wallField = assets->wallField;
+
+    stage->goalReached = false;
+    stage->goalReachedAt = 0.0;
+    stage->launched = false;
+    stage->restPosition = assets->initialPlayerPosition;
+    stage->victory = false;
+
+    ClearPhysicsWorld(&stage->world);
+    ReserveBodies(&stage->world.bodies, assets->bodyCount);
+
     // Create ball
-    stage.ball = CreatePhysicsBodyCircle(stage.initialPlayerPosition, PLAYER_RADIUS, 0.1f);
-    stage.ball->staticFriction = 0.0f;  // Friction when the body has not movement (0 to 1)
-    stage.ball->dynamicFriction = 0.0f; // Friction when the body has movement (0 to 1)
-    stage.ball->restitution = 1.0f;     // Restitution coefficient of the body (0 to 1)
-    stage.ball->useGravity = false;     // Apply gravity force to dynamics
-    stage.ball->freezeOrient = false;   // Physics rotation constraint
+    BodyStore *bodies = &stage->world.bodies;
+    stage->ball = CreateBody(bodies, stage->initialPlayerPosition, PLAYER_RADIUS);
+    bodies->restitution[stage->ball] = 1.0f; // Restitution coefficient of the body (0 to 1)
+    bodies->damping[stage->ball] = (BodyDamping){BALL_DECELERATION, BALL_REST_SPEED};
+}
+
+// Restart a stage at a level, keeping its buffers and where its stats go
+void ReloadStage(StageData *stage, int level)
+{
+    // Past the last level file the game is won and starts over
+    const StageAssets *assets = GetStageAssets(level);
+    bool victory = (assets == NULL);
+    if (victory)
+    {
+        assets = GetStageAssets(1);
+    }
+
+    SetupStage(stage, assets);
+    stage->victory = victory;
+}
+
+StageData LoadStage(int level)
+{
+    StageData stage = {0};
+    ReloadStage(&stage, level);
 
     return stage;
 }
 
+// Make destination an independent copy of source that can be simulated on its own (on
+// another thread, or ahead of the real stage). Buffers destination already owns are
+// reused, it must be zero initialized or a stage itself.
+void CopyStage(StageData *destination, const StageData *source)
+{
+    PhysicsWorld world = destination->world;
+
+    *destination = *source;
+    destination->world = world;
+    CopyPhysicsWorld(&destination->world, &source->world);
+}
+
+// Release what a stage owns, its assets stay cached for the next load
 void FreeStage(StageData *stage)
 {
-    ResetPhysics();
-    cute_tiled_free_map(stage->map);
-}
\ No newline at end of file
+    FreePhysicsWorld(&stage->world);
+}
+
+// Free the assets of every level, no StageData may be used afterwards
+void UnloadStages(void)
+{
+    for (int i = 0; i < stageCacheCount; i++)
+    {
+        FreeStageAssets(&stageCache[i]);
+    }
+
+    free(stageCache);
+    stageCache = NULL;
+    stageCacheCount = 0;
+    stageCacheCapacity = 0;
+}
@@ -0,0 +1,23 @@
+// Monotonic high resolution clock, usable without a window (raylib's GetTime needs one)
+#if defined(_WIN32)
+// Declared here to avoid pulling windows.h, which clashes with raylib names
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(unsigned long long *lpPerformanceCount);
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(unsigned long long *lpFrequency);
+#else
+#include <time.h>
+#endif
+
+// Get seconds elapsed since an arbitrary fixed point
+double GetMonotonicTime(void)
+{
+#if defined(_WIN32)
+    unsigned long long frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter / (double)frequency;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,228 @@
+// Circle against rotated rectangle overlap tests on several walls at once.
+// Walls are packed in struct-of-arrays form when the stage loads, in grid cell order,
+// so the walls of a cell sit next to each other and load straight into SIMD lanes.
+// AVX2 tests 8 walls per instruction, SSE2 and NEON test 4, other targets (or
+// WALL_BATCH_SCALAR) use the scalar loop.
+
+#if defined(WALL_BATCH_SCALAR)
+#define WALL_BATCH_WIDTH 4
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define WALL_BATCH_AVX2
+#define WALL_BATCH_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WALL_BATCH_SSE2
+#define WALL_BATCH_WIDTH 4
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define WALL_BATCH_NEON
+#define WALL_BATCH_WIDTH 4
+#else
+#define WALL_BATCH_SCALAR
+#define WALL_BATCH_WIDTH 4
+#endif
+
+typedef struct WallBatch
+{
+    int count;
+    int *wallIndex; // Wall each entry was packed from
+    float *centerX;
+    float *centerY;
+    float *axisX;
+    float *axisY;
+    float *halfWidth;
+    float *halfHeight;
+} WallBatch;
+
+// Pack walls (in the given index order, or as they are when indices is NULL).
+// Arrays are padded by one batch width so the last batch can always be loaded whole.
+WallBatch BuildWallBatch(const StageWall *walls, const int *indices, int count)
+{
+    WallBatch batch = {0};
+    int capacity = count + WALL_BATCH_WIDTH;
+
+    batch.count = count;
+    batch.wallIndex = (int *)calloc(capacity, sizeof(int));
+    batch.centerX = (float *)calloc(capacity * 6, sizeof(float));
+    batch.centerY = batch.centerX + capacity;
+    batch.axisX = batch.centerY + capacity;
+    batch.axisY = batch.axisX + capacity;
+    batch.halfWidth = batch.axisY + capacity;
+    batch.halfHeight = batch.halfWidth + capacity;
+
+    for (int i = 0; i < count; i++)
+    {
+        int index = (indices != NULL) ? indices[i] : i;
+        const StageWall *wall = &walls[index];
+
+        batch.wallIndex[i] = index;
+        batch.centerX[i] = wall->position.x;
+        batch.centerY[i] = wall->position.y;
+        batch.axisX[i] = wall->axis.x;
+        batch.axisY[i] = wall->axis.y;
+        batch.halfWidth[i] = wall->halfExtents.x;
+        batch.halfHeight[i] = wall->halfExtents.y;
+    }
+
+    return batch;
+}
+
+void FreeWallBatch(WallBatch *batch)
+{
+    free(batch->wallIndex);
+    free(batch->centerX);
+    *batch = (WallBatch){0};
+}
+
+// Bit i of the result is set when the circle overlaps entry first + i, for i < count
+int OverlapWallBatchScalar(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    int mask = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int entry = first + i;
+        float dx = center.x - batch->centerX[entry];
+        float dy = center.y - batch->centerY[entry];
+        float localX = dx * batch->axisX[entry] + dy * batch->axisY[entry];
+        float localY = dy * batch->axisX[entry] - dx * batch->axisY[entry];
+        float offsetX = localX - Clamp(localX, -batch->halfWidth[entry], batch->halfWidth[entry]);
+        float offsetY = localY - Clamp(localY, -batch->halfHeight[entry], batch->halfHeight[entry]);
+
+        if (offsetX * offsetX + offsetY * offsetY < radius * radius)
+        {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+#if defined(WALL_BATCH_AVX2)
+int OverlapWallBatchSimd(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    __m256 dx = _mm256_sub_ps(_mm256_set1_ps(center.x), _mm256_loadu_ps(batch->centerX + first));
+    __m256 dy = _mm256_sub_ps(_mm256_set1_ps(center.y), _mm256_loadu_ps(batch->centerY + first));
+    __m256 axisX = _mm256_loadu_ps(batch->axisX + first);
+    __m256 axisY = _mm256_loadu_ps(batch->axisY + first);
+    __m256 halfWidth = _mm256_loadu_ps(batch->halfWidth + first);
+    __m256 halfHeight = _mm256_loadu_ps(batch->halfHeight + first);
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 localX = _mm256_add_ps(_mm256_mul_ps(dx, axisX), _mm256_mul_ps(dy, axisY));
+    __m256 localY = _mm256_sub_ps(_mm256_mul_ps(dy, axisX), _mm256_mul_ps(dx, axisY));
+    __m256 offsetX = _mm256_sub_ps(localX, _mm256_min_ps(_mm256_max_ps(localX, _mm256_sub_ps(zero, halfWidth)), halfWidth));
+    __m256 offsetY = _mm256_sub_ps(localY, _mm256_min_ps(_mm256_max_ps(localY, _mm256_sub_ps(zero, halfHeight)), halfHeight));
+    __m256 distance = _mm256_add_ps(_mm256_mul_ps(offsetX, offsetX), _mm256_mul_ps(offsetY, offsetY));
+
+    int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_set1_ps(radius * radius), _CMP_LT_OQ));
+
+    return mask & ((1 << count) - 1);
+}
+#elif defined(WALL_BATCH_SSE2)
+int OverlapWallBatchSimd(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    __m128 dx = _mm_sub_ps(_mm_set1_ps(center.x), _mm_loadu_ps(batch->centerX + first));
+    __m128 dy = _mm_sub_ps(_mm_set1_ps(center.y), _mm_loadu_ps(batch->centerY + first));
+    __m128 axisX = _mm_loadu_ps(batch->axisX + first);
+    __m128 axisY = _mm_loadu_ps(batch->axisY + first);
+    __m128 halfWidth = _mm_loadu_ps(batch->halfWidth + first);
+    __m128 halfHeight = _mm_loadu_ps(batch->halfHeight + first);
+    __m128 zero = _mm_setzero_ps();
+
+    __m128 localX = _mm_add_ps(_mm_mul_ps(dx, axisX), _mm_mul_ps(dy, axisY));
+    __m128 localY = _mm_sub_ps(_mm_mul_ps(dy, axisX), _mm_mul_ps(dx, axisY));
+    __m128 offsetX = _mm_sub_ps(localX, _mm_min_ps(_mm_max_ps(localX, _mm_sub_ps(zero, halfWidth)), halfWidth));
+    __m128 offsetY = _mm_sub_ps(localY, _mm_min_ps(_mm_max_ps(localY, _mm_sub_ps(zero, halfHeight)), halfHeight));
+    __m128 distance = _mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY));
+
+    int mask = _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_set1_ps(radius * radius)));
+
+    return mask & ((1 << count) - 1);
+}
+#elif defined(WALL_BATCH_NEON)
+int OverlapWallBatchSimd(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    float32x4_t dx = vsubq_f32(vdupq_n_f32(center.x), vld1q_f32(batch->centerX + first));
+    float32x4_t dy = vsubq_f32(vdupq_n_f32(center.y), vld1q_f32(batch->centerY + first));
+    float32x4_t axisX = vld1q_f32(batch->axisX + first);
+    float32x4_t axisY = vld1q_f32(batch->axisY + first);
+    float32x4_t halfWidth = vld1q_f32(batch->halfWidth + first);
+    float32x4_t halfHeight = vld1q_f32(batch->halfHeight + first);
+
+    float32x4_t localX = vaddq_f32(vmulq_f32(dx, axisX), vmulq_f32(dy, axisY));
+    float32x4_t localY = vsubq_f32(vmulq_f32(dy, axisX), vmulq_f32(dx, axisY));
+    float32x4_t offsetX = vsubq_f32(localX, vminq_f32(vmaxq_f32(localX, vnegq_f32(halfWidth)), halfWidth));
+    float32x4_t offsetY = vsubq_f32(localY, vminq_f32(vmaxq_f32(localY, vnegq_f32(halfHeight)), halfHeight));
+    float32x4_t distance = vaddq_f32(vmulq_f32(offsetX, offsetX), vmulq_f32(offsetY, offsetY));
+
+    uint32x4_t overlap = vcltq_f32(distance, vdupq_n_f32(radius * radius));
+    int mask = (vgetq_lane_u32(overlap, 0) & 1) | (vgetq_lane_u32(overlap, 1) & 2) |
+               (vgetq_lane_u32(overlap, 2) & 4) | (vgetq_lane_u32(overlap, 3) & 8);
+
+    return mask & ((1 << count) - 1);
+}
+#else
+int OverlapWallBatchSimd(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    return OverlapWallBatchScalar(batch, first, count, center, radius);
+}
+#endif
+
+// Test up to WALL_BATCH_WIDTH consecutive entries starting at first
+int OverlapWallBatch(const WallBatch *batch, int first, int count, Vector2 center, float radius)
+{
+    return OverlapWallBatchSimd(batch, first, count, center, radius);
+}
+
+// Broadphase through the grid, then batched narrowphase over each overlapped cell.
+// The batch must be packed in grid order (grid->cellWalls). The number of walls the
+// broadphase handed to the narrowphase is added to *pairCount when it is not NULL.
+// The contacts replace the content of the list, which grows as needed.
+int FindWallContacts(const WallGrid *grid, const WallBatch *batch, const StageWall *walls, Vector2 center, float radius,
+                     WallContactList *list, int *pairCount)
+{
+    Rectangle area = {center.x - radius, center.y - radius, radius * 2.0f, radius * 2.0f};
+    int x0, x1, y0, y1;
+    list->count = 0;
+    if (!GetWallGridRange(grid, area, &x0, &x1, &y0, &y1))
+    {
+        return 0;
+    }
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            int cell = y * grid->columns + x;
+            int end = grid->cellStart[cell + 1];
+            if (pairCount != NULL)
+            {
+                *pairCount += end - grid->cellStart[cell];
+            }
+
+            for (int first = grid->cellStart[cell]; first < end; first += WALL_BATCH_WIDTH)
+            {
+                int count = (end - first < WALL_BATCH_WIDTH) ? end - first : WALL_BATCH_WIDTH;
+                int mask = OverlapWallBatch(batch, first, count, center, radius);
+
+                for (int lane = 0; mask != 0; lane++, mask >>= 1)
+                {
+                    const StageWall *wall = &walls[batch->wallIndex[first + lane]];
+
+                    if ((mask & 1) && IsFirstWallGridCell(grid, wall->bounds, x, y, x0, y0))
+                    {
+                        ReserveWallContacts(list, list->count + 1);
+                        if (GetWallContact(wall, center, radius, &list->contacts[list->count]))
+                        {
+                            list->count++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return list->count;
+}
@@ -0,0 +1,315 @@
+// Load time merging of the box walls. Levels build walls from many touching, axis
+// aligned rectangles: every group of boxes that touch or overlap is replaced by a cover
+// of its union with as few boxes as possible (grown right, then down, over the grid of
+// the group's distinct coordinates), whenever that gives fewer boxes than the group had
+// and none thinner, since the thinnest wall bounds the physics substep length.
+// Corners of a box whose edges continue into another box are marked hidden afterwards:
+// the faces of the boxes around such a corner already stop the ball, so a ball rolling
+// over the seam between two boxes never bounces off the corner in between.
+#define WALL_MERGE_EPSILON 0.01f
+#define WALL_MERGE_MAX_GROUP 256 // Larger groups keep their boxes, the coordinate grid grows quadratically
+
+static bool IsMergeableWall(const StageWall *wall)
+{
+    return wall->type == WALL_BOX && wall->axis.x == 1.0f && wall->axis.y == 0.0f;
+}
+
+static bool AreWallBoundsTouching(Rectangle a, Rectangle b)
+{
+    return a.x <= b.x + b.width + WALL_MERGE_EPSILON && b.x <= a.x + a.width + WALL_MERGE_EPSILON &&
+           a.y <= b.y + b.height + WALL_MERGE_EPSILON && b.y <= a.y + a.height + WALL_MERGE_EPSILON;
+}
+
+static int FindWallGroup(int *parent, int wall)
+{
+    while (parent[wall] != wall)
+    {
+        parent[wall] = parent[parent[wall]];
+        wall = parent[wall];
+    }
+    return wall;
+}
+
+static int CompareWallCoordinates(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+// Sort coordinates and drop the ones closer than the merge epsilon, returns the count left
+static int SortWallCoordinates(float *coordinates, int count)
+{
+    qsort(coordinates, count, sizeof(float), CompareWallCoordinates);
+
+    int unique = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (unique == 0 || coordinates[i] - coordinates[unique - 1] > WALL_MERGE_EPSILON)
+        {
+            coordinates[unique++] = coordinates[i];
+        }
+    }
+    return unique;
+}
+
+static int FindWallCoordinate(const float *coordinates, int count, float value)
+{
+    int index = 0;
+    while (index < count - 1 && coordinates[index] < value - WALL_MERGE_EPSILON)
+    {
+        index++;
+    }
+    return index;
+}
+
+// Cover the union of a group of boxes with boxes grown greedily over the coordinate grid.
+// Writes at most maxCount boxes, returns how many the cover needs (more than maxCount
+// when it would not be an improvement).
+static int CoverWallGroup(const StageWall *walls, const int *group, int groupCount, StageWall *cover, int maxCount)
+{
+    float *xs = (float *)malloc(groupCount * 2 * sizeof(float));
+    float *ys = (float *)malloc(groupCount * 2 * sizeof(float));
+    for (int i = 0; i < groupCount; i++)
+    {
+        Rectangle bounds = walls[group[i]].bounds;
+        xs[i * 2] = bounds.x;
+        xs[i * 2 + 1] = bounds.x + bounds.width;
+        ys[i * 2] = bounds.y;
+        ys[i * 2 + 1] = bounds.y + bounds.height;
+    }
+    int columns = SortWallCoordinates(xs, groupCount * 2) - 1;
+    int rows = SortWallCoordinates(ys, groupCount * 2) - 1;
+
+    // Cells of the union, cleared as boxes cover them
+    bool *solid = (bool *)calloc(columns * rows, sizeof(bool));
+    for (int i = 0; i < groupCount; i++)
+    {
+        Rectangle bounds = walls[group[i]].bounds;
+        int x0 = FindWallCoordinate(xs, columns + 1, bounds.x);
+        int x1 = FindWallCoordinate(xs, columns + 1, bounds.x + bounds.width);
+        int y0 = FindWallCoordinate(ys, rows + 1, bounds.y);
+        int y1 = FindWallCoordinate(ys, rows + 1, bounds.y + bounds.height);
+        for (int y = y0; y < y1; y++)
+        {
+            memset(&solid[y * columns + x0], true, (x1 - x0) * sizeof(bool));
+        }
+    }
+
+    int count = 0;
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < columns; x++)
+        {
+            if (!solid[y * columns + x])
+            {
+                continue;
+            }
+
+            int x1 = x + 1;
+            while (x1 < columns && solid[y * columns + x1])
+            {
+                x1++;
+            }
+            int y1 = y + 1;
+            bool fullRow = true;
+            while (y1 < rows && fullRow)
+            {
+                for (int i = x; i < x1 && fullRow; i++)
+                {
+                    fullRow = solid[y1 * columns + i];
+                }
+                y1 += fullRow;
+            }
+            for (int row = y; row < y1; row++)
+            {
+                memset(&solid[row * columns + x], false, (x1 - x) * sizeof(bool));
+            }
+
+            if (count < maxCount)
+            {
+                cover[count] = CreateStageWall((Rectangle){xs[x], ys[y], xs[x1] - xs[x], ys[y1] - ys[y]}, 0.0f);
+                cover[count].restitution = walls[group[0]].restitution;
+            }
+            count++;
+        }
+    }
+
+    free(solid);
+    free(ys);
+    free(xs);
+
+    return count;
+}
+
+// Smallest width or height of a set of boxes, all of them when indices is NULL
+static float GetThinnestWall(const StageWall *walls, const int *indices, int count)
+{
+    float thinnest = INFINITY;
+    for (int i = 0; i < count; i++)
+    {
+        const StageWall *wall = &walls[(indices != NULL) ? indices[i] : i];
+        thinnest = fminf(thinnest, fminf(wall->halfExtents.x, wall->halfExtents.y) * 2.0f);
+    }
+    return thinnest;
+}
+
+// Merge the touching axis aligned boxes of a wall array in place, other walls are kept
+// as they are. Returns the new wall count, never more than the old one.
+int MergeBoxWalls(StageWall *walls, int wallCount)
+{
+    if (wallCount < 2)
+    {
+        return wallCount;
+    }
+
+    // Group touching boxes, the grid only serves to find the neighbours
+    WallGrid grid = BuildWallGrid(walls, wallCount, WALL_GRID_CELL_SIZE);
+    int *parent = (int *)malloc(wallCount * sizeof(int));
+    for (int i = 0; i < wallCount; i++)
+    {
+        parent[i] = i;
+    }
+
+    for (int i = 0; i < wallCount; i++)
+    {
+        if (!IsMergeableWall(&walls[i]))
+        {
+            continue;
+        }
+
+        Rectangle bounds = walls[i].bounds;
+        Rectangle area = {bounds.x - WALL_MERGE_EPSILON, bounds.y - WALL_MERGE_EPSILON, bounds.width + WALL_MERGE_EPSILON * 2.0f,
+                          bounds.height + WALL_MERGE_EPSILON * 2.0f};
+        int x0, x1, y0, y1;
+        if (!GetWallGridRange(&grid, area, &x0, &x1, &y0, &y1))
+        {
+            continue;
+        }
+
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                int cell = y * grid.columns + x;
+                for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++)
+                {
+                    int other = grid.cellWalls[k];
+                    if (other != i && IsMergeableWall(&walls[other]) && AreWallBoundsTouching(bounds, walls[other].bounds))
+                    {
+                        parent[FindWallGroup(parent, other)] = FindWallGroup(parent, i);
+                    }
+                }
+            }
+        }
+    }
+    FreeWallGrid(&grid);
+
+    // Walls ordered by group, then each group is replaced by its cover when it is smaller
+    int *order = (int *)malloc(wallCount * sizeof(int));
+    int *groupStart = (int *)calloc(wallCount + 1, sizeof(int));
+    for (int i = 0; i < wallCount; i++)
+    {
+        groupStart[FindWallGroup(parent, i) + 1]++;
+    }
+    for (int i = 0; i < wallCount; i++)
+    {
+        groupStart[i + 1] += groupStart[i];
+    }
+    for (int i = 0; i < wallCount; i++)
+    {
+        order[groupStart[FindWallGroup(parent, i)]++] = i;
+    }
+
+    StageWall *merged = (StageWall *)malloc(wallCount * sizeof(StageWall));
+    int mergedCount = 0;
+    int first = 0;
+    for (int root = 0; root < wallCount; root++)
+    {
+        int end = groupStart[root];
+        int groupCount = end - first;
+        if (groupCount == 0)
+        {
+            continue;
+        }
+
+        int coverCount = (groupCount > 1 && groupCount <= WALL_MERGE_MAX_GROUP)
+                             ? CoverWallGroup(walls, &order[first], groupCount, &merged[mergedCount], groupCount - 1)
+                             : groupCount;
+        if (coverCount < groupCount && GetThinnestWall(&merged[mergedCount], NULL, coverCount) >= GetThinnestWall(walls, &order[first], groupCount))
+        {
+            mergedCount += coverCount;
+        }
+        else
+        {
+            for (int i = first; i < end; i++)
+            {
+                merged[mergedCount++] = walls[order[i]];
+            }
+        }
+        first = end;
+    }
+
+    memcpy(walls, merged, mergedCount * sizeof(StageWall));
+
+    free(merged);
+    free(groupStart);
+    free(order);
+    free(parent);
+
+    return mergedCount;
+}
+
+static bool IsWallPointCovered(const StageWall *walls, const WallGrid *grid, int wall, Vector2 point)
+{
+    Rectangle area = {point.x, point.y, 0.0f, 0.0f};
+    int x0, x1, y0, y1;
+    if (!GetWallGridRange(grid, area, &x0, &x1, &y0, &y1))
+    {
+        return false;
+    }
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            int cell = y * grid->columns + x;
+            for (int k = grid->cellStart[cell]; k < grid->cellStart[cell + 1]; k++)
+            {
+                int other = grid->cellWalls[k];
+                if (other != wall && IsMergeableWall(&walls[other]) &&
+                    AreWallBoundsTouching(area, walls[other].bounds))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Mark the corners of axis aligned boxes that continue into another such box: a corner is
+// hidden when a point just past it, along one of its two edges, lies on another box
+void HideWallSeamCorners(StageWall *walls, int wallCount, const WallGrid *grid)
+{
+    for (int i = 0; i < wallCount; i++)
+    {
+        if (!IsMergeableWall(&walls[i]))
+        {
+            continue;
+        }
+
+        for (int corner = 0; corner < 4; corner++)
+        {
+            Vector2 vertex = GetStageWallVertex(&walls[i], corner);
+            float outX = (corner == 1 || corner == 2) ? WALL_MERGE_EPSILON * 2.0f : -WALL_MERGE_EPSILON * 2.0f;
+            float outY = (corner >= 2) ? WALL_MERGE_EPSILON * 2.0f : -WALL_MERGE_EPSILON * 2.0f;
+
+            if (IsWallPointCovered(walls, grid, i, (Vector2){vertex.x + outX, vertex.y}) ||
+                IsWallPointCovered(walls, grid, i, (Vector2){vertex.x, vertex.y + outY}))
+            {
+                walls[i].hiddenCorners |= 1 << corner;
+            }
+        }
+    }
+}
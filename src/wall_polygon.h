@@ -0,0 +1,506 @@
+// Polygon and polyline walls from Tiled objects.
+// Tiled polygons can be concave, so when a stage loads they are cut into convex pieces
+// (ear clipping, then neighbouring triangles merged back while the result stays convex)
+// that the ball collides with one by one. Polylines become chains of two sided edges;
+// every edge knows its neighbours, so a ball rolling over the joint of two edges only
+// ever touches the faces and never catches the shared vertex.
+// Everything is in world space and precomputed at load time, like the box walls.
+#define WALL_POLYGON_MAX_VERTICES 8
+#define WALL_POLYGON_EPSILON 1e-4f
+
+// Convex polygon piece (vertices clockwise on screen), or edge of a chain (2 vertices)
+typedef struct WallPolygon
+{
+    int vertexCount;
+    Vector2 vertices[WALL_POLYGON_MAX_VERTICES];
+    Vector2 normals[WALL_POLYGON_MAX_VERTICES]; // Outward normal of the face from each vertex to the next
+
+    // Edges only: the far vertices of the neighbouring edges of the chain
+    bool hasPrevious;
+    bool hasNext;
+    Vector2 previous;
+    Vector2 next;
+} WallPolygon;
+
+static float GetPolygonCross(Vector2 a, Vector2 b, Vector2 c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static void SetPolygonNormals(WallPolygon *polygon)
+{
+    for (int i = 0; i < polygon->vertexCount; i++)
+    {
+        Vector2 edge = Vector2Subtract(polygon->vertices[(i + 1) % polygon->vertexCount], polygon->vertices[i]);
+        polygon->normals[i] = Vector2Normalize((Vector2){edge.y, -edge.x});
+    }
+}
+
+static bool IsPointInTriangle(Vector2 point, Vector2 a, Vector2 b, Vector2 c)
+{
+    return GetPolygonCross(a, b, point) >= 0 && GetPolygonCross(b, c, point) >= 0 && GetPolygonCross(c, a, point) >= 0;
+}
+
+// Ear clipping, the polygon must be wound with a positive cross product.
+// Writes triangles as index triples, returns how many were found.
+static int TriangulatePolygon(const Vector2 *points, int count, int *indices, int *triangles)
+{
+    int remaining = count;
+    int triangleCount = 0;
+
+    while (remaining > 3)
+    {
+        bool clipped = false;
+        for (int i = 0; i < remaining && !clipped; i++)
+        {
+            int previous = indices[(i + remaining - 1) % remaining];
+            int current = indices[i];
+            int next = indices[(i + 1) % remaining];
+            if (GetPolygonCross(points[previous], points[current], points[next]) <= 0)
+            {
+                continue; // Reflex vertex
+            }
+
+            bool ear = true;
+            for (int j = 0; j < remaining && ear; j++)
+            {
+                int other = indices[j];
+                ear = (other == previous || other == current || other == next ||
+                       !IsPointInTriangle(points[other], points[previous], points[current], points[next]));
+            }
+
+            if (ear)
+            {
+                triangles[triangleCount * 3] = previous;
+                triangles[triangleCount * 3 + 1] = current;
+                triangles[triangleCount * 3 + 2] = next;
+                triangleCount++;
+                memmove(&indices[i], &indices[i + 1], (remaining - i - 1) * sizeof(int));
+                remaining--;
+                clipped = true;
+            }
+        }
+
+        if (!clipped)
+        {
+            TraceLog(LOG_WARNING, "WALLS: Polygon is self intersecting, %d vertices left out", remaining);
+            return triangleCount;
+        }
+    }
+
+    triangles[triangleCount * 3] = indices[0];
+    triangles[triangleCount * 3 + 1] = indices[1];
+    triangles[triangleCount * 3 + 2] = indices[2];
+
+    return triangleCount + 1;
+}
+
+// Merge two pieces (as index lists) across the edge they share when the result is still
+// convex and small enough. Returns the merged vertex count, 0 when they cannot merge.
+static int MergePolygonPieces(const Vector2 *points, const int *a, int countA, const int *b, int countB, int *merged)
+{
+    if (countA + countB - 2 > WALL_POLYGON_MAX_VERTICES)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < countA; i++)
+    {
+        for (int j = 0; j < countB; j++)
+        {
+            // Shared edge a[i] -> a[i + 1] runs b[j + 1] -> b[j] in the other piece
+            if (a[i] != b[(j + 1) % countB] || a[(i + 1) % countA] != b[j])
+            {
+                continue;
+            }
+
+            int count = 0;
+            for (int k = 1; k <= countA; k++)
+            {
+                merged[count++] = a[(i + k) % countA];
+            }
+            for (int k = 2; k < countB; k++)
+            {
+                merged[count++] = b[(j + k) % countB];
+            }
+
+            for (int k = 0; k < count; k++)
+            {
+                if (GetPolygonCross(points[merged[k]], points[merged[(k + 1) % count]], points[merged[(k + 2) % count]]) <= 0)
+                {
+                    return 0;
+                }
+            }
+
+            return count;
+        }
+    }
+
+    return 0;
+}
+
+// Cut a simple polygon (any winding) into convex pieces of at most
+// WALL_POLYGON_MAX_VERTICES vertices. pieces needs room for count - 2 pieces.
+// Returns the number of pieces.
+int DecomposePolygon(const Vector2 *polygon, int count, WallPolygon *pieces)
+{
+    // Drop repeated vertices, and wind the polygon with a positive cross product
+    Vector2 *points = (Vector2 *)malloc(count * sizeof(Vector2));
+    int pointCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (pointCount == 0 || Vector2Distance(polygon[i], points[pointCount - 1]) > WALL_POLYGON_EPSILON)
+        {
+            points[pointCount++] = polygon[i];
+        }
+    }
+    if (pointCount > 1 && Vector2Distance(points[0], points[pointCount - 1]) <= WALL_POLYGON_EPSILON)
+    {
+        pointCount--;
+    }
+
+    float area = 0.0f;
+    for (int i = 0; i < pointCount; i++)
+    {
+        Vector2 a = points[i];
+        Vector2 b = points[(i + 1) % pointCount];
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area < 0)
+    {
+        for (int i = 0; i < pointCount / 2; i++)
+        {
+            Vector2 swap = points[i];
+            points[i] = points[pointCount - 1 - i];
+            points[pointCount - 1 - i] = swap;
+        }
+    }
+
+    if (pointCount < 3 || fabsf(area) <= WALL_POLYGON_EPSILON)
+    {
+        free(points);
+        return 0;
+    }
+
+    // Triangulate, then merge triangles back into convex pieces. Pieces are index lists,
+    // a merged piece takes the place of the first one and the second one is emptied.
+    int *indices = (int *)malloc(pointCount * sizeof(int));
+    int *triangles = (int *)malloc((pointCount - 2) * 3 * sizeof(int));
+    int *pieceIndices = (int *)malloc((pointCount - 2) * WALL_POLYGON_MAX_VERTICES * sizeof(int));
+    int *pieceCounts = (int *)malloc((pointCount - 2) * sizeof(int));
+    for (int i = 0; i < pointCount; i++)
+    {
+        indices[i] = i;
+    }
+
+    int triangleCount = TriangulatePolygon(points, pointCount, indices, triangles);
+    for (int i = 0; i < triangleCount; i++)
+    {
+        memcpy(&pieceIndices[i * WALL_POLYGON_MAX_VERTICES], &triangles[i * 3], 3 * sizeof(int));
+        pieceCounts[i] = 3;
+    }
+
+    bool merging = true;
+    while (merging)
+    {
+        merging = false;
+        for (int i = 0; i < triangleCount; i++)
+        {
+            for (int j = i + 1; j < triangleCount && pieceCounts[i] > 0; j++)
+            {
+                int merged[WALL_POLYGON_MAX_VERTICES];
+                int mergedCount = (pieceCounts[j] > 0) ? MergePolygonPieces(points, &pieceIndices[i * WALL_POLYGON_MAX_VERTICES], pieceCounts[i],
+                                                                            &pieceIndices[j * WALL_POLYGON_MAX_VERTICES], pieceCounts[j], merged)
+                                                       : 0;
+                if (mergedCount > 0)
+                {
+                    memcpy(&pieceIndices[i * WALL_POLYGON_MAX_VERTICES], merged, mergedCount * sizeof(int));
+                    pieceCounts[i] = mergedCount;
+                    pieceCounts[j] = 0;
+                    merging = true;
+                }
+            }
+        }
+    }
+
+    int pieceCount = 0;
+    for (int i = 0; i < triangleCount; i++)
+    {
+        if (pieceCounts[i] == 0)
+        {
+            continue;
+        }
+
+        WallPolygon *piece = &pieces[pieceCount++];
+        *piece = (WallPolygon){0};
+        piece->vertexCount = pieceCounts[i];
+        for (int k = 0; k < pieceCounts[i]; k++)
+        {
+            piece->vertices[k] = points[pieceIndices[i * WALL_POLYGON_MAX_VERTICES + k]];
+        }
+        SetPolygonNormals(piece);
+    }
+
+    free(pieceCounts);
+    free(pieceIndices);
+    free(triangles);
+    free(indices);
+    free(points);
+
+    return pieceCount;
+}
+
+// Turn a polyline into a chain of edges. edges needs room for count - 1 edges.
+// Returns the number of edges, zero length segments are skipped.
+int BuildEdgeChain(const Vector2 *points, int count, WallPolygon *edges)
+{
+    int edgeCount = 0;
+    for (int i = 0; i + 1 < count; i++)
+    {
+        if (Vector2Distance(points[i], points[i + 1]) <= WALL_POLYGON_EPSILON)
+        {
+            continue;
+        }
+
+        WallPolygon *edge = &edges[edgeCount];
+        *edge = (WallPolygon){0};
+        edge->vertexCount = 2;
+        edge->vertices[0] = points[i];
+        edge->vertices[1] = points[i + 1];
+        SetPolygonNormals(edge);
+
+        if (edgeCount > 0)
+        {
+            edge->hasPrevious = true;
+            edge->previous = edges[edgeCount - 1].vertices[0];
+            edges[edgeCount - 1].hasNext = true;
+            edges[edgeCount - 1].next = edge->vertices[1];
+        }
+        edgeCount++;
+    }
+
+    return edgeCount;
+}
+
+// Circle against convex polygon: the face the center is farthest out of decides
+// whether the face itself or one of its vertices is closest
+bool GetPolygonContact(const WallPolygon *polygon, Vector2 center, float radius, Vector2 *normal, float *penetration)
+{
+    int face = 0;
+    float separation = -INFINITY;
+    for (int i = 0; i < polygon->vertexCount; i++)
+    {
+        float s = Vector2DotProduct(polygon->normals[i], Vector2Subtract(center, polygon->vertices[i]));
+        if (s > radius)
+        {
+            return false;
+        }
+        if (s > separation)
+        {
+            separation = s;
+            face = i;
+        }
+    }
+
+    Vector2 a = polygon->vertices[face];
+    Vector2 b = polygon->vertices[(face + 1) % polygon->vertexCount];
+
+    if (separation <= 0 || (Vector2DotProduct(Vector2Subtract(center, a), Vector2Subtract(b, a)) > 0 &&
+                            Vector2DotProduct(Vector2Subtract(center, b), Vector2Subtract(a, b)) > 0))
+    {
+        // Center inside, or facing the face
+        *normal = polygon->normals[face];
+        *penetration = radius - separation;
+        return true;
+    }
+
+    Vector2 vertex = (Vector2DotProduct(Vector2Subtract(center, a), Vector2Subtract(b, a)) <= 0) ? a : b;
+    float distance = Vector2Distance(center, vertex);
+    if (distance >= radius)
+    {
+        return false;
+    }
+
+    *normal = Vector2Scale(Vector2Subtract(center, vertex), 1.0f / distance);
+    *penetration = radius - distance;
+    return true;
+}
+
+// Circle against a chain edge. Past the start vertex the contact belongs to the
+// previous edge when the center still faces it; the end vertex is always left to the
+// next edge, so a shared vertex is reported once and only where it really sticks out.
+bool GetEdgeContact(const WallPolygon *edge, Vector2 center, float radius, Vector2 *normal, float *penetration)
+{
+    Vector2 a = edge->vertices[0];
+    Vector2 b = edge->vertices[1];
+    Vector2 direction = Vector2Subtract(b, a);
+    float u = Vector2DotProduct(Vector2Subtract(center, a), direction);
+    float v = Vector2DotProduct(Vector2Subtract(b, center), direction);
+    Vector2 closest;
+
+    if (u <= 0)
+    {
+        if (edge->hasPrevious && Vector2DotProduct(Vector2Subtract(center, a), Vector2Subtract(a, edge->previous)) < 0)
+        {
+            return false;
+        }
+        closest = a;
+    }
+    else if (v <= 0)
+    {
+        if (edge->hasNext)
+        {
+            return false;
+        }
+        closest = b;
+    }
+    else
+    {
+        closest = Vector2Add(a, Vector2Scale(direction, u / Vector2DotProduct(direction, direction)));
+    }
+
+    Vector2 offset = Vector2Subtract(center, closest);
+    float distance = Vector2Length(offset);
+    if (distance >= radius)
+    {
+        return false;
+    }
+
+    // A center right on the edge is pushed out along the face normal
+    *normal = (distance > 0) ? Vector2Scale(offset, 1.0f / distance) : edge->normals[0];
+    *penetration = radius - distance;
+    return true;
+}
+
+// Time of impact of a circle moving by displacement against a convex polygon, as a
+// fraction of the displacement. The circle is swept as a ray against the polygon grown
+// by the radius: faces pushed out by the radius, joined by circles around the vertices.
+// Circles already touching the polygon report no impact, like the box walls.
+bool SweepPolygon(const WallPolygon *polygon, Vector2 center, float radius, Vector2 displacement, float *timeOfImpact,
+                  Vector2 *normal)
+{
+    Vector2 touchNormal;
+    float penetration;
+    if (GetPolygonContact(polygon, center, radius, &touchNormal, &penetration))
+    {
+        return false;
+    }
+
+    bool hit = false;
+    *timeOfImpact = INFINITY;
+
+    for (int i = 0; i < polygon->vertexCount; i++)
+    {
+        Vector2 a = polygon->vertices[i];
+        Vector2 b = polygon->vertices[(i + 1) % polygon->vertexCount];
+        Vector2 faceNormal = polygon->normals[i];
+
+        // Face pushed out by the radius
+        float approach = Vector2DotProduct(displacement, faceNormal);
+        if (approach < 0)
+        {
+            float t = (radius - Vector2DotProduct(Vector2Subtract(center, a), faceNormal)) / approach;
+            Vector2 point = Vector2Add(center, Vector2Scale(displacement, t));
+            Vector2 direction = Vector2Subtract(b, a);
+            float u = Vector2DotProduct(Vector2Subtract(point, a), direction);
+            if (t >= 0 && t <= 1.0f && t < *timeOfImpact && u >= 0 && u <= Vector2DotProduct(direction, direction))
+            {
+                *timeOfImpact = t;
+                *normal = faceNormal;
+                hit = true;
+            }
+        }
+
+        // Circle around the vertex
+        Vector2 offset = Vector2Subtract(center, a);
+        float q = Vector2DotProduct(displacement, displacement);
+        float p = Vector2DotProduct(offset, displacement);
+        float k = Vector2DotProduct(offset, offset) - radius * radius;
+        float discriminant = p * p - q * k;
+        if (p < 0 && discriminant >= 0)
+        {
+            float t = (-p - sqrtf(discriminant)) / q;
+            if (t <= 1.0f && t < *timeOfImpact)
+            {
+                *timeOfImpact = t;
+                *normal = Vector2Scale(Vector2Add(offset, Vector2Scale(displacement, t)), 1.0f / radius);
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
+
+// Time of impact of a circle moving by displacement against a chain edge: the edge
+// grown by the radius is a capsule. The rounded ends follow the vertex rules of
+// GetEdgeContact(), so a ball moving along a chain never bumps into the joints.
+bool SweepEdge(const WallPolygon *edge, Vector2 center, float radius, Vector2 displacement, float *timeOfImpact,
+               Vector2 *normal)
+{
+    Vector2 a = edge->vertices[0];
+    Vector2 b = edge->vertices[1];
+    Vector2 direction = Vector2Subtract(b, a);
+    float lengthSquared = Vector2DotProduct(direction, direction);
+    float u = Clamp(Vector2DotProduct(Vector2Subtract(center, a), direction) / lengthSquared, 0.0f, 1.0f);
+    if (Vector2Distance(center, Vector2Add(a, Vector2Scale(direction, u))) < radius)
+    {
+        return false;
+    }
+
+    bool hit = false;
+    *timeOfImpact = INFINITY;
+
+    // Both faces, pushed out by the radius
+    for (int side = 0; side < 2; side++)
+    {
+        Vector2 faceNormal = (side == 0) ? edge->normals[0] : Vector2Negate(edge->normals[0]);
+        float approach = Vector2DotProduct(displacement, faceNormal);
+        if (approach >= 0)
+        {
+            continue;
+        }
+
+        float t = (radius - Vector2DotProduct(Vector2Subtract(center, a), faceNormal)) / approach;
+        Vector2 point = Vector2Add(center, Vector2Scale(displacement, t));
+        float projection = Vector2DotProduct(Vector2Subtract(point, a), direction);
+        if (t >= 0 && t <= 1.0f && projection >= 0 && projection <= lengthSquared)
+        {
+            *timeOfImpact = t;
+            *normal = faceNormal;
+            hit = true;
+        }
+    }
+
+    // Start vertex, the end vertex is swept by the next edge when there is one
+    for (int end = 0; end < 2; end++)
+    {
+        Vector2 vertex = edge->vertices[end];
+        if (end == 1 && edge->hasNext)
+        {
+            continue;
+        }
+
+        Vector2 offset = Vector2Subtract(center, vertex);
+        float q = Vector2DotProduct(displacement, displacement);
+        float p = Vector2DotProduct(offset, displacement);
+        float k = Vector2DotProduct(offset, offset) - radius * radius;
+        float discriminant = p * p - q * k;
+        if (p >= 0 || discriminant < 0)
+        {
+            continue;
+        }
+
+        float t = (-p - sqrtf(discriminant)) / q;
+        Vector2 hitOffset = Vector2Add(offset, Vector2Scale(displacement, t));
+        bool facesPrevious = (end == 0 && edge->hasPrevious && Vector2DotProduct(hitOffset, Vector2Subtract(a, edge->previous)) < 0);
+        if (t <= 1.0f && t < *timeOfImpact && !facesPrevious)
+        {
+            *timeOfImpact = t;
+            *normal = Vector2Scale(hitOffset, 1.0f / radius);
+            hit = true;
+        }
+    }
+
+    return hit;
+}
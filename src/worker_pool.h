@@ -0,0 +1,82 @@
+// Minimal parallel for: runs task(index) for every index in [0, count) on all cores.
+// Workers pull indices from a shared atomic counter, so uneven tasks balance themselves.
+#include <pthread.h>
+#include <stdatomic.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#define MAX_WORKERS 64
+
+typedef void (*WorkerTask)(int index, void *userData);
+
+typedef struct WorkerJob
+{
+    WorkerTask task;
+    void *userData;
+    int count;
+    atomic_int next;
+} WorkerJob;
+
+int GetWorkerCount(void)
+{
+#if defined(_WIN32)
+    // Avoids windows.h, which clashes with raylib names
+    const char *processors = getenv("NUMBER_OF_PROCESSORS");
+    int count = (processors != NULL) ? atoi(processors) : 1;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (count < 1) ? 1 : (count > MAX_WORKERS) ? MAX_WORKERS : count;
+}
+
+static void *RunWorker(void *argument)
+{
+    WorkerJob *job = (WorkerJob *)argument;
+
+    for (int index = atomic_fetch_add(&job->next, 1); index < job->count; index = atomic_fetch_add(&job->next, 1))
+    {
+        job->task(index, job->userData);
+    }
+
+    return NULL;
+}
+
+// Same as RunParallel() on at most workerCount threads, to measure how work scales
+void RunParallelOn(int workerCount, int count, WorkerTask task, void *userData)
+{
+    WorkerJob job = {.task = task, .userData = userData, .count = count};
+    atomic_init(&job.next, 0);
+
+    if (workerCount > MAX_WORKERS)
+    {
+        workerCount = MAX_WORKERS;
+    }
+    if (workerCount > count)
+    {
+        workerCount = count;
+    }
+
+    // The calling thread works too
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+    for (int i = 1; i < workerCount; i++)
+    {
+        if (pthread_create(&threads[started], NULL, RunWorker, &job) == 0)
+        {
+            started++;
+        }
+    }
+
+    RunWorker(&job);
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+void RunParallel(int count, WorkerTask task, void *userData)
+{
+    RunParallelOn(GetWorkerCount(), count, task, userData);
+}